@@ -0,0 +1,541 @@
+// Throughput of the decoders, views and bulk functions, on corpora of several sizes, of fragments of real text and
+// generated ones, see utf-8/corpus.h.
+//
+// Usage: utf-8_bench [-c] [FILTER]
+//
+// Every benchmark whose name, "case/corpus/size", contains FILTER is run, and reported in GB/s and in cycles per byte,
+// in bytes of UTF-8. Cycles are time-stamp counter cycles, at the nominal frequency of the CPU, on x86 only. Bulk
+// kernels are run for every instruction set the CPU supports, on valid corpora only, and decoding kernels fall back to
+// utf8::decoder for the bytes they make no progress on, as the library does.
+//
+// With -c, hardware performance counters are read too, through perf_event_open on Linux only, and reported per byte:
+// core cycles, instructions, branch misses and L1 data cache read misses. Counters the kernel or the CPU does not
+// provide are reported as "-".
+
+#include "utf-8.h"
+#include "utf-8/corpus.h"
+#include "utf-8/detail/dispatch.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#if defined(_MSC_VER) and not defined(__clang__)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <random>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+/// @brief Input of the benchmarks, in all encodings
+struct corpus {
+	std::string name;
+	std::u8string bytes;
+	std::string chars;
+	std::u32string code_points;
+	std::u16string code_units;
+	bool valid{};
+
+	// Output buffers, allocated once, large enough for every benchmark
+	mutable std::u32string out32;
+	mutable std::u16string out16;
+	mutable std::u8string out8;
+};
+
+/// @brief Make a corpus of the given bytes, in all encodings
+auto make_corpus(std::string name, std::u8string bytes) -> corpus
+{
+	corpus out{};
+	out.name = std::move(name);
+	out.bytes = std::move(bytes);
+
+	out.chars.assign(out.bytes.begin(), out.bytes.end());
+	out.code_points.resize(out.bytes.size());
+	out.code_points.resize(utf8::to_utf32(out.bytes, out.code_points));
+	out.code_units.resize(out.bytes.size());
+	out.code_units.resize(utf8::to_utf16(out.bytes, out.code_units));
+	out.valid = utf8::validate(out.bytes);
+
+	out.out32.resize(out.bytes.size());
+	out.out16.resize(out.bytes.size());
+	out.out8.resize(std::max(4 * out.code_points.size(), 3 * out.code_units.size()));
+
+	return out;
+}
+
+/// @brief Generate a corpus of the given size, drawing fragments of text at random from a mix, with a fixed seed
+auto make_corpus(std::string name, std::span<const std::u8string_view> mix, std::size_t size) -> corpus
+{
+	std::mt19937 generator{size};
+	std::u8string bytes;
+
+	while (bytes.size() < size) {
+		bytes += mix[generator() % mix.size()];
+	}
+	bytes.resize(size);
+	while (not utf8::detail::is_unit_boundary(bytes, bytes.size())) {
+		bytes.pop_back();
+	}
+
+	return make_corpus(std::move(name), std::move(bytes));
+}
+
+/// @brief Generate a corpus of the given size, see utf-8/corpus.h
+auto make_corpus(std::string name, const utf8::corpus::options &options, std::size_t size) -> corpus
+{
+	return make_corpus(std::move(name), utf8::corpus::generate(options, size));
+}
+
+/// @brief Generate corpora of the given size
+///
+/// The first ones are made of fragments of real text, with its runs of ASCII spaces and punctuation, and its branch
+/// patterns. The others are generated, named after the lengths of their characters, drawn at random, and have the
+/// branch patterns of random text.
+auto make_corpora(std::size_t size) -> std::vector<corpus>
+{
+	static constexpr std::array<std::u8string_view, 6> latin{u8"Le cœur ", u8"déçu ", u8"mais l'âme ",
+								 u8"plutôt naïve, ", u8"Louÿs rêva ", u8"d'un ça. "};
+	static constexpr std::array<std::u8string_view, 4> cyrillic{u8"Съешь же ", u8"ещё этих ", u8"мягких ",
+								    u8"французских булок. "};
+	static constexpr std::array<std::u8string_view, 4> cjk{u8"我能吞下玻璃而不伤身体。", u8"私はガラスを食べられます。",
+							       u8"나는 유리를 먹을 수 있어요. ", u8"中文 "};
+	static constexpr std::array<std::u8string_view, 5> emoji{u8"🦊", u8"🐶🐱", u8"👍🏽 ", u8"ok ", u8"🇫🇷"};
+
+	std::vector<corpus> corpora;
+	corpora.push_back(make_corpus("latin", latin, size));
+	corpora.push_back(make_corpus("cyrillic", cyrillic, size));
+	corpora.push_back(make_corpus("cjk", cjk, size));
+	corpora.push_back(make_corpus("emoji", emoji, size));
+	corpora.push_back(make_corpus("ascii", {.seed = 1, .lengths = {1, 0, 0, 0}}, size));
+	corpora.push_back(make_corpus("mostly-ascii", {.seed = 2, .lengths = {9, 1, 0, 0}}, size));
+	corpora.push_back(make_corpus("2-byte", {.seed = 3, .lengths = {1, 4, 0, 0}}, size));
+	corpora.push_back(make_corpus("3-byte", {.seed = 4, .lengths = {1, 0, 4, 0}}, size));
+	corpora.push_back(make_corpus("4-byte", {.seed = 5, .lengths = {1, 0, 0, 1}}, size));
+	corpora.push_back(make_corpus("mixed", {.seed = 6, .lengths = {1, 1, 1, 1}}, size));
+	corpora.push_back(make_corpus("errors", {.seed = 7, .lengths = {4, 2, 2, 1}, .error_rate = 0.05}, size));
+
+	return corpora;
+}
+
+/// @brief A benchmark case, returning a value which depends on the whole computation
+struct bench_case {
+	std::string name;
+	std::function<std::size_t(const corpus &)> run;
+	bool valid_only{};
+};
+
+auto cycles() -> std::uint64_t
+{
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/// @brief Hardware event counts, scaled for the time the counters were multiplexed, NaN for those not available
+struct events {
+	static constexpr std::size_t count = 4;
+
+	std::array<double, count> values{};
+};
+
+/// @brief Hardware performance counters of the calling thread, read as a group, on Linux only
+class counters {
+#if defined(__linux__)
+	std::array<int, events::count> fds_{-1, -1, -1, -1}; // The first one leads the group.
+#endif
+
+public:
+	counters()
+	{
+#if defined(__linux__)
+		static constexpr std::uint64_t l1d_read_miss = PERF_COUNT_HW_CACHE_L1D |
+							       (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+							       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		static constexpr std::array<std::pair<std::uint32_t, std::uint64_t>, events::count> configs{{
+		    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+		    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+		    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+		    {PERF_TYPE_HW_CACHE, l1d_read_miss},
+		}};
+
+		for (std::size_t i = 0; i < events::count; ++i) {
+			perf_event_attr attributes{};
+			attributes.size = sizeof(attributes);
+			attributes.type = configs.at(i).first;
+			attributes.config = configs.at(i).second;
+			attributes.disabled = i == 0 ? 1 : 0; // Members follow their leader.
+			attributes.exclude_kernel = 1;
+			attributes.exclude_hv = 1;
+			attributes.read_format =
+			    PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+			// Without a leader, there is no group, and events the CPU lacks are skipped.
+			const auto leader = fds_[0];
+			if (i != 0 and leader < 0) {
+				break;
+			}
+			fds_.at(i) = static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, leader, 0));
+		}
+#endif
+	}
+
+	counters(const counters &) = delete;
+	auto operator=(const counters &) -> counters & = delete;
+
+	~counters()
+	{
+#if defined(__linux__)
+		for (const auto fd : fds_) {
+			if (fd >= 0) {
+				::close(fd);
+			}
+		}
+#endif
+	}
+
+	[[nodiscard]] auto available() const -> bool
+	{
+#if defined(__linux__)
+		return fds_[0] >= 0;
+#else
+		return false;
+#endif
+	}
+
+	void start()
+	{
+#if defined(__linux__)
+		if (available()) {
+			::ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+			::ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		}
+#endif
+	}
+
+	auto stop() -> events
+	{
+		events out{};
+		out.values.fill(std::numeric_limits<double>::quiet_NaN());
+
+#if defined(__linux__)
+		if (not available()) {
+			return out;
+		}
+		::ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+		// The number of events, the times enabled and running, then the values, in the order events were opened
+		std::array<std::uint64_t, 3 + events::count> data{};
+		if (::read(fds_[0], data.data(), sizeof(data)) < 0 or data[2] == 0) {
+			return out;
+		}
+		const auto scale = static_cast<double>(data[1]) / static_cast<double>(data[2]);
+		for (std::size_t i = 0, value = 3; i < events::count; ++i) {
+			if (fds_.at(i) >= 0 and value < 3 + data[0]) {
+				out.values.at(i) = static_cast<double>(data.at(value++)) * scale;
+			}
+		}
+#endif
+
+		return out;
+	}
+};
+
+auto isa_name(utf8::detail::isa set) -> std::string
+{
+	switch (set) {
+	case utf8::detail::isa::scalar:
+		return "scalar";
+	case utf8::detail::isa::sse42:
+		return "sse42";
+	case utf8::detail::isa::avx2:
+		return "avx2";
+	case utf8::detail::isa::avx512:
+		return "avx512";
+	}
+	return {};
+}
+
+/// @brief Run a decoding kernel over a whole sequence, decoding the bytes it makes no progress on as the library does
+///
+/// @param bytes The UTF-8 sequence
+/// @param window The number of bytes to decode without the kernel when it makes no progress
+/// @param step The kernel, taking the rest of the sequence and the number of code units produced so far
+///
+/// @return The number of code units produced, those of the bytes decoded without the kernel being counted only
+template <typename Step>
+auto drive(std::span<const char8_t> bytes, std::size_t window, Step step) -> std::size_t
+{
+	std::size_t consumed{};
+	std::size_t produced{};
+	utf8::decoder decoder{};
+
+	while (consumed < bytes.size()) {
+		const auto result = step(bytes.subspan(consumed), produced);
+		consumed += result.consumed;
+		produced += result.produced;
+		if (result.consumed != 0) {
+			continue;
+		}
+
+		const auto end = std::min(consumed + window, bytes.size());
+		while (consumed < bytes.size() and (consumed < end or decoder.check_last_error().has_value())) {
+			if (decoder.decode(bytes[consumed++]).has_value()) {
+				produced += decoder.fetch().has_value() ? 2 : 1;
+			}
+		}
+	}
+
+	return produced;
+}
+
+auto make_cases() -> std::vector<bench_case>
+{
+	std::vector<bench_case> cases;
+
+	cases.push_back({"decoder", [](const corpus &c) {
+				 std::size_t sum{};
+				 utf8::decoder decoder{};
+				 for (const auto byte : c.bytes) {
+					 if (const auto code = decoder.decode(byte)) {
+						 sum += *code;
+						 sum += decoder.fetch().value_or(0);
+					 }
+				 }
+				 return sum + decoder.check_last_error().value_or(0);
+			 }});
+	cases.push_back({"shift_decoder", [](const corpus &c) {
+				 std::size_t sum{};
+				 utf8::shift_decoder decoder{};
+				 for (const auto byte : c.bytes) {
+					 if (const auto code = decoder.decode(byte)) {
+						 sum += *code;
+						 sum += decoder.fetch().value_or(0);
+					 }
+				 }
+				 return sum + decoder.check_last_error().value_or(0);
+			 }});
+	cases.push_back({"views::decode", [](const corpus &c) {
+				 std::size_t sum{};
+				 for (const auto code : std::u8string_view{c.bytes} | utf8::views::decode) {
+					 sum += code;
+				 }
+				 return sum;
+			 }});
+	cases.push_back({"views::decode(char)", [](const corpus &c) {
+				 std::size_t sum{};
+				 for (const auto code : std::string_view{c.chars} | utf8::views::decode) {
+					 sum += code;
+				 }
+				 return sum;
+			 }});
+	cases.push_back({"views::utf8_to_utf32", [](const corpus &c) {
+				 std::size_t sum{};
+				 for (const auto code : std::u8string_view{c.bytes} | utf8::views::utf8_to_utf32) {
+					 sum += code;
+				 }
+				 return sum;
+			 }});
+	cases.push_back({"views::encode", [](const corpus &c) {
+				 std::size_t sum{};
+				 for (const auto byte : std::u32string_view{c.code_points} | utf8::views::encode) {
+					 sum += byte;
+				 }
+				 return sum;
+			 }});
+
+	cases.push_back({"validate", [](const corpus &c) { return std::size_t{utf8::validate(c.bytes)}; }});
+	cases.push_back({"find_first_error", [](const corpus &c) { return utf8::find_first_error(c.bytes); }});
+	cases.push_back({"count_code_points", [](const corpus &c) { return utf8::count_code_points(c.bytes); }});
+	cases.push_back({"to_utf32", [](const corpus &c) { return utf8::to_utf32(c.bytes, c.out32); }});
+	cases.push_back({"to_utf16", [](const corpus &c) { return utf8::to_utf16(c.bytes, c.out16); }});
+	cases.push_back({"from_utf32", [](const corpus &c) { return utf8::from_utf32(c.code_points, c.out8); }});
+	cases.push_back({"from_utf16", [](const corpus &c) { return utf8::from_utf16(c.code_units, c.out8); }});
+
+	for (const auto set : {utf8::detail::isa::scalar, utf8::detail::isa::sse42, utf8::detail::isa::avx2,
+			       utf8::detail::isa::avx512}) {
+		if (not utf8::detail::supports(set)) {
+			continue;
+		}
+		const auto *kernels = &utf8::detail::kernels_for(set);
+		const auto suffix = "<" + isa_name(set) + ">";
+
+		cases.push_back({"validate" + suffix,
+				 [=](const corpus &c) { return std::size_t{kernels->validate(c.bytes)}; }, true});
+		cases.push_back({"to_utf32" + suffix,
+				 [=](const corpus &c) {
+					 return drive(c.bytes, kernels->window, [&](auto rest, std::size_t produced) {
+						 return kernels->to_utf32(rest, c.out32.data() + produced);
+					 });
+				 },
+				 true});
+		cases.push_back({"to_utf16" + suffix,
+				 [=](const corpus &c) {
+					 return drive(c.bytes, kernels->window, [&](auto rest, std::size_t produced) {
+						 return kernels->to_utf16(rest, c.out16.data() + produced);
+					 });
+				 },
+				 true});
+		cases.push_back({"count_code_points" + suffix,
+				 [=](const corpus &c) {
+					 return drive(c.bytes, kernels->window, [&](auto rest, std::size_t) {
+						 return kernels->count_code_points(rest);
+					 });
+				 },
+				 true});
+		cases.push_back({"from_utf32" + suffix,
+				 [=](const corpus &c) { return kernels->from_utf32(c.code_points, c.out8).produced; },
+				 true});
+		cases.push_back({"from_utf16" + suffix,
+				 [=](const corpus &c) { return kernels->from_utf16(c.code_units, c.out8).produced; },
+				 true});
+	}
+
+	return cases;
+}
+
+/// @brief Time and events of a benchmark case, per iteration
+struct measurement {
+	double time{};
+	double cycles{};
+	events hardware{};
+};
+
+/// @brief Time a benchmark case on a corpus, as the best of several runs of enough iterations
+///
+/// @param hardware The counters to read during the runs, if any
+///
+/// @return The time, cycles and events, if counted, of the best run, per iteration
+auto measure(const bench_case &bench, const corpus &input, counters *hardware, std::size_t &sink) -> measurement
+{
+	using clock = std::chrono::steady_clock;
+	static constexpr std::chrono::milliseconds min_run{50};
+	static constexpr auto runs = 5;
+
+	// Enough iterations for a run to last long enough to be measured accurately
+	std::size_t iterations = 1;
+	for (;;) {
+		const auto start = clock::now();
+		for (std::size_t i = 0; i < iterations; ++i) {
+			sink += bench.run(input);
+		}
+		if (clock::now() - start >= min_run) {
+			break;
+		}
+		iterations *= 2;
+	}
+
+	measurement best{.time = std::numeric_limits<double>::max()};
+	for (auto run = 0; run < runs; ++run) {
+		if (hardware != nullptr) {
+			hardware->start();
+		}
+		const auto start = clock::now();
+		const auto start_cycles = cycles();
+		for (std::size_t i = 0; i < iterations; ++i) {
+			sink += bench.run(input);
+		}
+		const auto elapsed_cycles = static_cast<double>(cycles() - start_cycles);
+		const std::chrono::duration<double> elapsed = clock::now() - start;
+		const auto counted = hardware != nullptr ? hardware->stop() : events{};
+
+		const auto time = elapsed.count() / static_cast<double>(iterations);
+		if (time < best.time) {
+			best = {time, elapsed_cycles / static_cast<double>(iterations), counted};
+			for (auto &value : best.hardware.values) {
+				value /= static_cast<double>(iterations);
+			}
+		}
+	}
+
+	return best;
+}
+
+} // namespace
+
+auto main(int argc, char *argv[]) -> int
+{
+	const std::vector<std::string_view> args(argv + 1, argv + argc);
+	const auto count_events = not args.empty() and args.front() == "-c";
+	const std::string_view filter = args.size() > (count_events ? 1 : 0) ? args.back() : "";
+	const auto cases = make_cases();
+	std::size_t sink{};
+
+	std::optional<counters> hardware;
+	if (count_events) {
+		hardware.emplace();
+		if (not hardware->available()) {
+			std::fprintf(stderr, "Hardware performance counters are not available.\n");
+		}
+	}
+
+	std::printf("%-34s %-13s %8s %10s %12s", "case", "corpus", "size", "GB/s", "cycles/byte");
+	if (count_events) {
+		std::printf(" %10s %10s %10s %10s", "core-cyc/B", "instr/B", "br-miss/B", "l1d-miss/B");
+	}
+	std::printf("\n");
+
+	for (const std::size_t size : {std::size_t{1} << 10, std::size_t{1} << 16, std::size_t{1} << 24}) {
+		const auto corpora = make_corpora(size);
+		const auto size_name =
+		    size < (1U << 20) ? std::to_string(size >> 10) + "K" : std::to_string(size >> 20) + "M";
+
+		for (const auto &bench : cases) {
+			for (const auto &input : corpora) {
+				const auto name = bench.name + "/" + input.name + "/" + size_name;
+				if ((bench.valid_only and not input.valid) or name.find(filter) == std::string::npos) {
+					continue;
+				}
+
+				const auto result = measure(bench, input, hardware ? &*hardware : nullptr, sink);
+				const auto bytes = static_cast<double>(input.bytes.size());
+				std::printf("%-34s %-13s %8s %10.2f %12.3f", bench.name.c_str(), input.name.c_str(),
+					    size_name.c_str(), bytes / result.time / 1e9, result.cycles / bytes);
+				const auto &values = result.hardware.values;
+				for (const auto value : std::span{values}.first(count_events ? values.size() : 0)) {
+					if (std::isnan(value)) {
+						std::printf(" %10s", "-");
+					} else {
+						std::printf(" %10.4f", value / bytes);
+					}
+				}
+				std::printf("\n");
+				std::fflush(stdout);
+			}
+		}
+	}
+
+	// The checksum depends on every result, so that no benchmark may be optimized away.
+	std::printf("checksum %zu\n", sink);
+
+	return 0;
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+
+// Deterministic synthetic UTF-8 corpora, for benchmarks and stress tests. A corpus is a sequence of fragments, each of
+// which is either a valid character or an error, drawn at random from a seeded SplitMix64 generator. Both the generator
+// and the mapping of its draws to fragments are defined here, rather than by the standard random number engines and
+// distributions, which are either slow or implementation defined, so the same options give the same corpus anywhere.
+
+namespace utf8::corpus {
+
+/// @brief Categories of errors a corpus may hold, those the tests of the decoders exercise
+enum class error : unsigned char {
+	overlong,   ///< A code point encoded on more bytes than needed, two to four
+	surrogate,  ///< A surrogate, U+D800 to U+DFFF, encoded on three bytes
+	truncated,  ///< A character of two to four bytes, without one or more of its continuation bytes
+	impossible, ///< A byte which never appears in UTF-8: 0xC0, 0xC1 or 0xF5 to 0xFF
+};
+
+/// @brief Number of categories of errors
+constexpr inline std::size_t error_categories = 4;
+
+/// @brief Maximum number of bytes of a fragment
+constexpr inline std::size_t max_fragment_size = 4;
+
+/// @brief Parameters of a corpus
+struct options {
+	std::uint64_t seed{};
+	std::array<unsigned, 4> lengths{1, 1, 1, 1}; ///< Relative weights of the characters of one to four bytes
+	double error_rate{};                         ///< Probability that a fragment is an error, not a character
+	std::array<unsigned, error_categories> errors{1, 1, 1, 1}; ///< Relative weights of the utf8::corpus::error
+};
+
+/// @brief Fragments of a corpus generated so far
+struct statistics {
+	std::size_t characters{};
+	std::array<std::size_t, error_categories> errors{}; ///< Per utf8::corpus::error
+};
+
+/// @brief Generator of a corpus, an endless sequence of bytes
+///
+/// Code points are uniformly distributed among those of the length drawn, surrogates excluded, and code points of
+/// errors among those the category allows.
+class generator {
+	/// @brief A character or an error
+	struct fragment {
+		std::array<char8_t, max_fragment_size> bytes;
+		std::size_t size;
+		std::optional<error> category;
+	};
+
+	/// @brief SplitMix64, small and fast, with a period of 2^64
+	class engine {
+		std::uint64_t state_;
+
+	public:
+		explicit engine(std::uint64_t seed) : state_{seed} {}
+
+		auto operator()() -> std::uint64_t
+		{
+			auto z = state_ += 0x9e3779b97f4a7c15;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+			return z ^ (z >> 31);
+		}
+	};
+
+	/// @brief First code point of every length of encoding
+	static constexpr std::array<std::uint64_t, 5> first_codes{0, 0, 0x80, 0x800, 0x10000};
+
+	engine random_;
+	std::array<std::uint64_t, 4> lengths_{};               // Cumulative weights
+	std::array<std::uint64_t, error_categories> errors_{}; // Cumulative weights
+	std::uint64_t error_threshold_{};                      // Draws below it are errors
+	fragment pending_{};           // The fragment the last fill left incomplete, if any
+	std::size_t pending_offset_{}; // Of the first byte of pending_ not filled yet
+	statistics statistics_{};
+
+	/// @brief Map a draw of 32 bits to an integer in [0, bound), without a division
+	static auto uniform(std::uint64_t draw, std::uint64_t bound) -> std::uint64_t
+	{
+		return (draw & 0xffffffff) * bound >> 32;
+	}
+
+	/// @brief Pick an index at random, given cumulative weights, the last one being their sum
+	template <std::size_t N>
+	static auto pick(const std::array<std::uint64_t, N> &cumulative, std::uint64_t draw) -> std::size_t
+	{
+		// The top 30 bits of the draw, since the sum of the weights may take up to 34
+		const auto value = (draw >> 34) * cumulative.back() >> 30;
+
+		// Without branches, which lengths or categories drawn at random would mispredict
+		std::size_t index{};
+		for (std::size_t i = 0; i + 1 < N; ++i) {
+			index += value >= cumulative[i] ? 1 : 0;
+		}
+		return index;
+	}
+
+	template <std::size_t N>
+	static auto accumulate(const std::array<unsigned, N> &weights) -> std::array<std::uint64_t, N>
+	{
+		std::array<std::uint64_t, N> cumulative{};
+		std::uint64_t sum{};
+		for (std::size_t i = 0; i < N; ++i) {
+			sum += weights.at(i);
+			cumulative.at(i) = sum;
+		}
+		if (sum == 0) {
+			cumulative.fill(1); // The first category only
+		}
+		return cumulative;
+	}
+
+	/// @brief Encode a code point on a given number of bytes, possibly more than needed
+	static auto encode(std::uint64_t code, std::size_t length) -> fragment
+	{
+		static constexpr std::array<std::uint64_t, 5> leads{0, 0x00, 0xc0, 0xe0, 0xf0};
+		static constexpr std::uint64_t data_mask = 0x3f;
+		static constexpr std::uint64_t data_shift = 6;
+
+		// Without branches either, the bytes beyond the length being left unspecified
+		const auto continuation = [&](std::size_t i) {
+			const auto shift = data_shift * ((length - 1 - i) & 3);
+			return static_cast<char8_t>(0x80 | ((code >> shift) & data_mask));
+		};
+		return {{static_cast<char8_t>(leads[length] | (code >> (data_shift * (length - 1)))), continuation(1),
+			 continuation(2), continuation(3)},
+			length,
+			std::nullopt};
+	}
+
+	/// @brief Encode a code point of a given length, from a draw of 32 bits, surrogates excluded
+	static auto valid(std::size_t length, std::uint64_t draw) -> fragment
+	{
+		static constexpr std::array<std::uint64_t, 5> counts{0, 0x80, 0x780, 0xf000, 0x100000};
+		static constexpr std::uint64_t surrogates = 0xd800;
+
+		auto code = first_codes[length] + uniform(draw, counts[length]);
+		code += length == 3 and code >= surrogates ? 0x800 : 0;
+		return encode(code, length);
+	}
+
+	auto character() -> fragment
+	{
+		// One draw for both the length, in the upper bits, and the code point, in the lower ones
+		const auto draw = random_();
+
+		return valid(1 + pick(lengths_, draw), draw);
+	}
+
+	auto make_error() -> fragment
+	{
+		static constexpr std::array<char8_t, 13> impossible{0xc0, 0xc1, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9,
+								    0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff};
+
+		// The category and the number of bytes kept of a truncated character come from the upper and lower bits
+		// of a first draw, the length and the code point from those of a second one.
+		const auto first = random_();
+		const auto second = random_();
+		const auto category = static_cast<error>(pick(errors_, first));
+		const auto length = 2 + uniform(second >> 32, 3);
+		const auto kept = 1 + uniform(first, length - 1);
+		const auto code = second;
+		fragment out{};
+
+		switch (category) {
+		case error::overlong:
+			out = encode(uniform(code, first_codes.at(length)), length);
+			break;
+		case error::surrogate:
+			out = encode(0xd800 + uniform(code, 0x800), 3);
+			break;
+		case error::truncated:
+			out = valid(length, code);
+			out.size = kept;
+			break;
+		case error::impossible:
+			out = {{impossible.at(uniform(code, impossible.size()))}, 1, {}};
+			break;
+		}
+
+		out.category = category;
+		return out;
+	}
+
+	auto next() -> fragment
+	{
+		return error_threshold_ != 0 and random_() < error_threshold_ ? make_error() : character();
+	}
+
+	void record(const fragment &done)
+	{
+		if (done.category.has_value()) {
+			++statistics_.errors[static_cast<std::size_t>(*done.category)];
+		} else {
+			++statistics_.characters;
+		}
+	}
+
+public:
+	/// @brief Create a generator
+	///
+	/// @param parameters The parameters of the corpus, in which weights all null are the same as a weight for the
+	/// first category only
+	explicit generator(const options &parameters)
+	    : random_{parameters.seed}, lengths_{accumulate(parameters.lengths)},
+	      errors_{accumulate(parameters.errors)}
+	{
+		static constexpr auto draws = 64;
+
+		if (parameters.error_rate >= 1) {
+			error_threshold_ = std::numeric_limits<std::uint64_t>::max();
+		} else if (parameters.error_rate > 0) {
+			error_threshold_ = static_cast<std::uint64_t>(std::ldexp(parameters.error_rate, draws));
+		}
+	}
+
+	/// @brief Generate the next bytes of the corpus
+	///
+	/// @param bytes The output, filled completely
+	/// @param complete Whether the output shall end at a fragment boundary, with a fragment which does not fit
+	/// dropped, and the bytes of it which do replaced by ASCII spaces, or be continued by the next call
+	///
+	/// @pre If complete, the output holds at least the rest of the fragment the last call left incomplete, if any,
+	/// which is always the case of an output of utf8::corpus::max_fragment_size bytes or more.
+	///
+	/// @note Filling two outputs in a row, not complete, generates the same bytes as filling one holding both.
+	void fill(std::span<char8_t> bytes, bool complete = false)
+	{
+		std::size_t size{};
+
+		// The fragment left incomplete by the last call first, if any
+		const auto flush = [&] {
+			if (pending_.size == 0) {
+				return;
+			}
+			while (pending_offset_ < pending_.size and size < bytes.size()) {
+				bytes[size++] = pending_.bytes.at(pending_offset_++);
+			}
+			if (pending_offset_ == pending_.size) {
+				record(pending_);
+				pending_ = {};
+				pending_offset_ = 0;
+			}
+		};
+		flush();
+
+		// As long as there is room for any fragment, it is copied whole.
+		while (bytes.size() - size >= max_fragment_size) {
+			const auto done = next();
+			std::ranges::copy(done.bytes, bytes.begin() + static_cast<std::ptrdiff_t>(size));
+			size += done.size;
+			record(done);
+		}
+
+		while (size < bytes.size()) {
+			pending_ = next();
+			flush();
+		}
+
+		// Since the output held the rest of any fragment the last call left incomplete, one still pending was
+		// started by this call, and all of its bytes are in the output.
+		if (complete and pending_offset_ != 0) {
+			const auto count = std::min(pending_offset_, bytes.size());
+			std::fill(bytes.end() - static_cast<std::ptrdiff_t>(count), bytes.end(), u8' ');
+			pending_ = {};
+			pending_offset_ = 0;
+		}
+	}
+
+	/// @brief Get the fragments generated so far, not counting one left incomplete by the last fill
+	[[nodiscard]] auto generated() const -> const statistics & { return statistics_; }
+};
+
+/// @brief Generate a corpus
+///
+/// @param parameters The parameters of the corpus
+/// @param size The size of the corpus, in bytes
+///
+/// @return The corpus, ending at a fragment boundary, see utf8::corpus::generator::fill
+inline auto generate(const options &parameters, std::size_t size) -> std::u8string
+{
+	std::u8string bytes(size, u8'\0');
+	generator{parameters}.fill(bytes, true);
+	return bytes;
+}
+
+} // namespace utf8::corpus
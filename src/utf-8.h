@@ -1,8 +1,27 @@
 #pragma once
 
+#include "utf-8/count.h"
 #include "utf-8/decoder.h"
+#include "utf-8/detail/scalar.h"
+#include "utf-8/detail/units.h"
+#include "utf-8/encode.h"
+#include "utf-8/encoder.h"
+#include "utf-8/index.h"
+#include "utf-8/segments.h"
+#include "utf-8/shift_decoder.h"
+#include "utf-8/stream_decoder.h"
+#include "utf-8/transcode.h"
+#include "utf-8/validate.h"
+#include "utf-8/validator.h"
 
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <ranges>
+#include <span>
 
 namespace utf8 {
 
@@ -14,10 +33,17 @@ concept viewable_range_of = std::ranges::viewable_range<R> and std::same_as<std:
 template <typename R, typename T>
 concept input_range_of = std::ranges::input_range<R> and std::same_as<std::ranges::range_value_t<R>, T>;
 
+template <typename R>
+concept code_point_range =
+    std::ranges::input_range<R> and std::convertible_to<std::ranges::range_value_t<R>, unsigned long>;
+
 } // namespace detail
 
 /// @brief Decode a UTF-8 range into Unicode code points
 /// @tparam V The input range type
+///
+/// The view is a forward range over forward ranges, and a bidirectional range over bidirectional ranges, decoding
+/// backward into the exact same code points as forward, including replacement characters.
 template <detail::input_range_of<char8_t> V>
 	requires std::ranges::view<V>
 class decode_view : public std::ranges::view_interface<decode_view<V>> {
@@ -25,19 +51,31 @@ class decode_view : public std::ranges::view_interface<decode_view<V>> {
 
 	struct nothing {};
 
-	class iterator {
+	// Over contiguous memory, runs of ASCII bytes are detected a word at a time and delivered without delimiting
+	// their units one by one. Longer scans pay off on pure ASCII, but cost more than they save on text which mixes
+	// ASCII with other characters.
+	static constexpr bool ascii_fast_path =
+	    std::ranges::contiguous_range<V> and
+	    std::sized_sentinel_for<std::ranges::sentinel_t<V>, std::ranges::iterator_t<V>>;
+	static constexpr uint8_t max_ascii_run = 8;
+
+	// Over input ranges, bytes can only be read once, so they are fed to the decoder.
+	class input_iterator {
 		std::ranges::iterator_t<V> it_{};
 		std::ranges::sentinel_t<V> end_{};
 		utf8::decoder decoder_{};
-		unsigned long code_{};
-		bool has_last_error_{};
+		// The current code point, with last_error_ set if it concludes a sequence ending with an incomplete
+		// character, since code points never take more than 21 bits.
+		uint32_t code_{};
+
+		static constexpr uint32_t last_error_ = uint32_t{1} << 31;
 
 		constexpr void try_decode_one_code_point()
 		{
 			const auto code = decoder_.fetch();
 
 			if (code.has_value()) {
-				code_ = *code;
+				code_ = static_cast<uint32_t>(*code);
 				return;
 			}
 
@@ -57,11 +95,10 @@ class decode_view : public std::ranges::view_interface<decode_view<V>> {
 
 			if (it_ == end_) {
 				if ((code = decoder_.check_last_error()).has_value()) {
-					has_last_error_ = true;
-					code_ = *code;
+					code_ = static_cast<uint32_t>(*code) | last_error_;
 				}
 			} else {
-				code_ = *code;
+				code_ = static_cast<uint32_t>(*code);
 			}
 		}
 
@@ -69,37 +106,476 @@ class decode_view : public std::ranges::view_interface<decode_view<V>> {
 		using difference_type = ptrdiff_t;
 		using value_type = unsigned long;
 
-		constexpr iterator(auto &&it, auto &&end)
+		constexpr input_iterator(auto &&it, auto &&end)
 		    : it_{std::forward<decltype(it)>(it)}, end_{std::forward<decltype(end)>(end)}
 		{
 			decode();
 		}
-		constexpr auto operator++() -> iterator &
+		constexpr auto operator++() -> input_iterator &
 		{
-			if (has_last_error_) {
-				has_last_error_ = false;
+			if ((code_ & last_error_) != 0) {
+				code_ &= ~last_error_;
 			} else {
 				try_decode_one_code_point();
 			}
 			return *this;
 		}
 		constexpr void operator++(int) { ++(*this); }
-		constexpr auto operator*() const -> value_type { return code_; }
+		constexpr auto operator*() const -> value_type { return code_ & ~last_error_; }
 		constexpr auto operator==(nothing /*not_used*/) const -> bool
 		{
-			return it_ == end_ and not has_last_error_;
+			return it_ == end_ and (code_ & last_error_) == 0;
 		}
 	};
 
+	// Over forward ranges, the iterator delimits the unit of bytes every code point comes from (see
+	// utf-8/detail/units.h), which is what makes it possible to move backward.
+	class unit_iterator {
+		std::ranges::iterator_t<V> begin_{};
+		std::ranges::iterator_t<V> pos_{};
+		std::ranges::iterator_t<V> next_{};
+		std::ranges::sentinel_t<V> end_{};
+		uint32_t code_{};
+		uint8_t ascii_run_{}; // Number of ASCII bytes known to follow the current unit
+
+		constexpr void decode()
+		{
+			next_ = pos_;
+			if (pos_ == end_) {
+				return;
+			}
+			if constexpr (ascii_fast_path) {
+				// An ASCII byte is a unit on its own, and so is every ASCII byte after it.
+				if (*pos_ < 0x80) {
+					const auto size = std::min<std::size_t>(end_ - pos_, max_ascii_run);
+					ascii_run_ = static_cast<uint8_t>(
+					    detail::scalar::ascii_prefix(std::span{std::to_address(pos_), size}) - 1);
+					code_ = *next_++;
+					return;
+				}
+			}
+			code_ = static_cast<uint32_t>(detail::decode_unit(next_, end_));
+		}
+
+	public:
+		using difference_type = ptrdiff_t;
+		using value_type = unsigned long;
+		using iterator_concept = std::conditional_t<std::ranges::bidirectional_range<V>,
+							    std::bidirectional_iterator_tag, std::forward_iterator_tag>;
+
+		unit_iterator() = default;
+		constexpr unit_iterator(std::ranges::iterator_t<V> begin, std::ranges::iterator_t<V> pos,
+					std::ranges::sentinel_t<V> end)
+		    : begin_{std::move(begin)}, pos_{std::move(pos)}, end_{std::move(end)}
+		{
+			decode();
+		}
+		constexpr auto operator++() -> unit_iterator &
+		{
+			pos_ = next_;
+			if constexpr (ascii_fast_path) {
+				if (ascii_run_ > 0) {
+					--ascii_run_;
+					code_ = *next_++;
+					return *this;
+				}
+			}
+			decode();
+			return *this;
+		}
+		constexpr auto operator++(int) -> unit_iterator
+		{
+			auto previous = *this;
+			++(*this);
+			return previous;
+		}
+		constexpr auto operator--() -> unit_iterator &
+			requires std::ranges::bidirectional_range<V>
+		{
+			next_ = pos_;
+			code_ = static_cast<uint32_t>(detail::decode_previous_unit(begin_, pos_));
+			ascii_run_ = 0;
+			return *this;
+		}
+		constexpr auto operator--(int) -> unit_iterator
+			requires std::ranges::bidirectional_range<V>
+		{
+			auto next = *this;
+			--(*this);
+			return next;
+		}
+		constexpr auto operator*() const -> value_type { return code_; }
+		constexpr auto operator==(const unit_iterator &other) const -> bool { return pos_ == other.pos_; }
+		constexpr auto operator==(nothing /*not_used*/) const -> bool { return pos_ == end_; }
+	};
+
+	using iterator = std::conditional_t<std::ranges::forward_range<V>, unit_iterator, input_iterator>;
+
 public:
 	constexpr decode_view(V view) : view_{std::move(view)} {}
+	constexpr auto begin() -> iterator
+	{
+		if constexpr (std::ranges::forward_range<V>) {
+			return {std::ranges::begin(view_), std::ranges::begin(view_), std::ranges::end(view_)};
+		} else {
+			return {std::ranges::begin(view_), std::ranges::end(view_)};
+		}
+	}
+	constexpr auto end()
+	{
+		if constexpr (std::ranges::forward_range<V> and std::ranges::common_range<V>) {
+			return iterator{std::ranges::begin(view_), std::ranges::end(view_), std::ranges::end(view_)};
+		} else {
+			return nothing{};
+		}
+	}
+};
+
+// Deduction guide
+template <typename R>
+decode_view(R &&) -> decode_view<std::views::all_t<R>>;
+
+/// @brief Encode a range of Unicode code points into UTF-16
+/// @tparam V The input range type
+///
+/// Code points beyond the Basic Multilingual Plane become surrogate pairs, and values which are not Unicode scalar
+/// values become U+FFFD.
+template <detail::code_point_range V>
+	requires std::ranges::view<V>
+class to_utf16_view : public std::ranges::view_interface<to_utf16_view<V>> {
+	V view_{};
+
+	struct nothing {};
+
+	class iterator {
+		std::ranges::iterator_t<V> it_{};
+		std::ranges::sentinel_t<V> end_{};
+		std::array<char16_t, 2> units_{};
+		uint8_t index_{};
+		uint8_t size_{};
+
+		constexpr void encode()
+		{
+			index_ = 0;
+			if (it_ != end_) {
+				const auto code = static_cast<unsigned long>(*it_);
+				size_ = static_cast<uint8_t>(detail::encode_utf16(code, units_.data()));
+			}
+		}
+
+	public:
+		using difference_type = ptrdiff_t;
+		using value_type = char16_t;
+
+		constexpr iterator(auto &&it, auto &&end)
+		    : it_{std::forward<decltype(it)>(it)}, end_{std::forward<decltype(end)>(end)}
+		{
+			encode();
+		}
+		constexpr auto operator++() -> iterator &
+		{
+			if (++index_ == size_) {
+				++it_;
+				encode();
+			}
+			return *this;
+		}
+		constexpr void operator++(int) { ++(*this); }
+		constexpr auto operator*() const -> value_type { return units_.at(index_); }
+		constexpr auto operator==(nothing /*not_used*/) const -> bool { return it_ == end_; }
+	};
+
+public:
+	constexpr to_utf16_view(V view) : view_{std::move(view)} {}
 	constexpr auto begin() -> iterator { return {std::ranges::begin(view_), std::ranges::end(view_)}; }
 	constexpr auto end() -> nothing { return {}; }
 };
 
 // Deduction guide
 template <typename R>
-decode_view(R &&) -> decode_view<std::views::all_t<R>>;
+to_utf16_view(R &&) -> to_utf16_view<std::views::all_t<R>>;
+
+/// @brief Encode a range of Unicode code points into UTF-8
+/// @tparam V The input range type
+///
+/// Every code point is encoded at once, and its bytes are then served from the iterator. Values which are not Unicode
+/// scalar values become U+FFFD, as with utf8::encoder.
+template <detail::code_point_range V>
+	requires std::ranges::view<V>
+class encode_view : public std::ranges::view_interface<encode_view<V>> {
+	V view_{};
+
+	struct nothing {};
+
+	class iterator {
+		std::ranges::iterator_t<V> it_{};
+		std::ranges::sentinel_t<V> end_{};
+		std::array<char8_t, 4> bytes_{};
+		uint8_t index_{};
+		uint8_t size_{};
+
+		constexpr void encode()
+		{
+			index_ = 0;
+			if (it_ != end_) {
+				const auto code = static_cast<unsigned long>(*it_);
+				size_ = static_cast<uint8_t>(detail::encode_utf8(code, bytes_.data()));
+			}
+		}
+
+	public:
+		using difference_type = ptrdiff_t;
+		using value_type = char8_t;
+
+		constexpr iterator(auto &&it, auto &&end)
+		    : it_{std::forward<decltype(it)>(it)}, end_{std::forward<decltype(end)>(end)}
+		{
+			encode();
+		}
+		constexpr auto operator++() -> iterator &
+		{
+			if (++index_ == size_) {
+				++it_;
+				encode();
+			}
+			return *this;
+		}
+		constexpr void operator++(int) { ++(*this); }
+		constexpr auto operator*() const -> value_type { return bytes_.at(index_); }
+		constexpr auto operator==(nothing /*not_used*/) const -> bool { return it_ == end_; }
+	};
+
+public:
+	constexpr encode_view(V view) : view_{std::move(view)} {}
+	constexpr auto begin() -> iterator { return {std::ranges::begin(view_), std::ranges::end(view_)}; }
+	constexpr auto end() -> nothing { return {}; }
+};
+
+// Deduction guide
+template <typename R>
+encode_view(R &&) -> encode_view<std::views::all_t<R>>;
+
+/// @brief Transcode a UTF-16 range into UTF-8
+/// @tparam V The input range type
+///
+/// Unpaired surrogates, including a high surrogate at the end of the range, become U+FFFD, exactly as with
+/// utf8::from_utf16.
+template <detail::input_range_of<char16_t> V>
+	requires std::ranges::view<V>
+class from_utf16_view : public std::ranges::view_interface<from_utf16_view<V>> {
+	V view_{};
+
+	struct nothing {};
+
+	class iterator {
+		std::ranges::iterator_t<V> it_{};
+		std::ranges::sentinel_t<V> end_{};
+		std::array<char8_t, 4> bytes_{};
+		uint8_t index_{};
+		uint8_t size_{};
+		char16_t next_{}; // Code unit read after a high surrogate which it does not pair with
+		bool has_next_{};
+
+		constexpr void encode()
+		{
+			index_ = 0;
+			size_ = 0;
+			if (not has_next_) {
+				if (it_ == end_) {
+					return;
+				}
+				next_ = static_cast<char16_t>(*it_);
+				++it_;
+			}
+			has_next_ = false;
+
+			unsigned long code = next_;
+			if (detail::is_high_surrogate(next_) and it_ != end_) {
+				const auto unit = static_cast<char16_t>(*it_);
+				++it_;
+				if (detail::is_surrogate_pair(next_, unit)) {
+					code = detail::decode_surrogate_pair(next_, unit);
+				} else {
+					next_ = unit;
+					has_next_ = true;
+				}
+			}
+			size_ = static_cast<uint8_t>(detail::encode_utf8(code, bytes_.data()));
+		}
+
+	public:
+		using difference_type = ptrdiff_t;
+		using value_type = char8_t;
+
+		constexpr iterator(auto &&it, auto &&end)
+		    : it_{std::forward<decltype(it)>(it)}, end_{std::forward<decltype(end)>(end)}
+		{
+			encode();
+		}
+		constexpr auto operator++() -> iterator &
+		{
+			if (++index_ == size_) {
+				encode();
+			}
+			return *this;
+		}
+		constexpr void operator++(int) { ++(*this); }
+		constexpr auto operator*() const -> value_type { return bytes_.at(index_); }
+		constexpr auto operator==(nothing /*not_used*/) const -> bool { return size_ == 0; }
+	};
+
+public:
+	constexpr from_utf16_view(V view) : view_{std::move(view)} {}
+	constexpr auto begin() -> iterator { return {std::ranges::begin(view_), std::ranges::end(view_)}; }
+	constexpr auto end() -> nothing { return {}; }
+};
+
+// Deduction guide
+template <typename R>
+from_utf16_view(R &&) -> from_utf16_view<std::views::all_t<R>>;
+
+/// @brief Transcode a UTF-8 range into UTF-16 or UTF-32, without an intermediate range of code points
+/// @tparam V The input range type
+/// @tparam Char The output code unit type, char16_t or char32_t
+///
+/// The code units are exactly the ones of utf8::views::decode, followed by utf8::views::to_utf16 for UTF-16. Contiguous
+/// ranges are transcoded in bulk by the SIMD kernels at run time, into a buffer allocated by every iterator, and the
+/// windows in error by utf8::decoder. Other ranges are fed to utf8::decoder, whose code points are encoded right away.
+///
+/// @note The iterators of contiguous ranges own their buffer, so they are move-only, and every pass over the view is
+/// independent of the others.
+template <detail::input_range_of<char8_t> V, detail::utf_code_unit Char>
+	requires std::ranges::view<V>
+class transcode_view : public std::ranges::view_interface<transcode_view<V, Char>> {
+	// Enough for the kernels to transcode a few windows at a time
+	static constexpr std::size_t buffer_size = 4 * detail::kernel_window;
+	static constexpr bool bulk = std::ranges::contiguous_range<V> and
+				     std::sized_sentinel_for<std::ranges::sentinel_t<V>, std::ranges::iterator_t<V>>;
+
+	using buffer = std::array<Char, bulk ? buffer_size : 4>;
+
+	struct nothing {};
+
+	V view_{};
+
+	class iterator {
+		std::ranges::iterator_t<V> it_{};
+		std::ranges::sentinel_t<V> end_{};
+		decoder state_{};
+		bool finished_{};
+		// Number of bytes to decode one at a time, since the kernels made no progress on them
+		std::size_t fallback_{};
+		// Allocated for bulk transcoding, so that moves are cheap, otherwise the code units of one code point
+		std::conditional_t<bulk, std::unique_ptr<buffer>, buffer> units_{};
+		std::size_t index_{};
+		std::size_t size_{};
+
+		constexpr auto units() -> buffer &
+		{
+			if constexpr (bulk) {
+				return *units_;
+			} else {
+				return units_;
+			}
+		}
+		constexpr auto units() const -> const buffer &
+		{
+			if constexpr (bulk) {
+				return *units_;
+			} else {
+				return units_;
+			}
+		}
+
+		constexpr void push(unsigned long code)
+		{
+			if constexpr (std::same_as<Char, char16_t>) {
+				size_ += detail::encode_utf16(code, units().data() + size_);
+			} else {
+				units().at(size_++) = static_cast<char32_t>(code);
+			}
+		}
+
+		constexpr void decode(char8_t byte)
+		{
+			if (const auto code = state_.decode(byte)) {
+				push(*code);
+				if (const auto extra = state_.fetch()) {
+					push(*extra);
+				}
+			}
+		}
+
+		constexpr void transcode()
+		{
+			index_ = 0;
+			size_ = 0;
+
+			if constexpr (bulk) {
+				// At character boundaries, the kernels transcode as much as the buffer holds.
+				while (size_ == 0 and it_ != end_) {
+					const auto *data = std::to_address(it_);
+					const auto size = std::min(static_cast<std::size_t>(end_ - it_), buffer_size);
+					std::size_t consumed{};
+
+					if (fallback_ == 0 and not state_.check_last_error().has_value()) {
+						std::size_t window{};
+						const auto result = detail::transcode_bulk(std::span{data, size},
+											   units().data(), window);
+						consumed = result.consumed;
+						size_ = result.produced;
+						fallback_ = consumed == 0 ? window : 0;
+					}
+					if (consumed == 0) {
+						decode(*data);
+						consumed = 1;
+						fallback_ -= fallback_ != 0 ? 1 : 0;
+					}
+					it_ += static_cast<std::ranges::range_difference_t<V>>(consumed);
+				}
+			} else {
+				for (; size_ == 0 and it_ != end_; ++it_) {
+					decode(static_cast<char8_t>(*it_));
+				}
+			}
+
+			if (size_ == 0 and not finished_) {
+				finished_ = true;
+				if (const auto code = state_.check_last_error()) {
+					push(*code);
+				}
+			}
+		}
+
+	public:
+		using difference_type = ptrdiff_t;
+		using value_type = Char;
+
+		constexpr iterator(auto &&it, auto &&end)
+		    : it_{std::forward<decltype(it)>(it)}, end_{std::forward<decltype(end)>(end)}
+		{
+			if constexpr (bulk) {
+				units_ = std::make_unique<buffer>();
+			}
+			transcode();
+		}
+		constexpr auto operator++() -> iterator &
+		{
+			if (++index_ == size_) {
+				transcode();
+			}
+			return *this;
+		}
+		constexpr void operator++(int) { ++(*this); }
+		constexpr auto operator*() const -> value_type { return units().at(index_); }
+		constexpr auto operator==(nothing /*not_used*/) const -> bool { return size_ == 0; }
+	};
+
+public:
+	constexpr transcode_view(V view) : view_{std::move(view)} {}
+	constexpr auto begin() -> iterator { return {std::ranges::begin(view_), std::ranges::end(view_)}; }
+	constexpr auto end() -> nothing { return {}; }
+};
 
 namespace views::detail {
 
@@ -119,11 +595,59 @@ struct decode : std::ranges::range_adaptor_closure<decode> {
 	}
 };
 
+struct to_utf16 : std::ranges::range_adaptor_closure<to_utf16> {
+	template <std::ranges::viewable_range R>
+		requires utf8::detail::code_point_range<R>
+	constexpr auto operator()(R &&arg) const
+	{
+		return to_utf16_view{std::forward<R>(arg)};
+	}
+};
+
+struct encode : std::ranges::range_adaptor_closure<encode> {
+	template <std::ranges::viewable_range R>
+		requires utf8::detail::code_point_range<R>
+	constexpr auto operator()(R &&arg) const
+	{
+		return encode_view{std::forward<R>(arg)};
+	}
+};
+
+struct from_utf16 : std::ranges::range_adaptor_closure<from_utf16> {
+	template <utf8::detail::viewable_range_of<char16_t> R>
+	constexpr auto operator()(R &&arg) const
+	{
+		return from_utf16_view{std::forward<R>(arg)};
+	}
+};
+
+template <typename Char>
+struct transcode : std::ranges::range_adaptor_closure<transcode<Char>> {
+	template <utf8::detail::viewable_range_of<char8_t> R>
+	constexpr auto operator()(R &&arg) const
+	{
+		return transcode_view<std::views::all_t<R>, Char>{std::forward<R>(arg)};
+	}
+
+	// Overload for ranges of char, which are transcoded without the bulk kernels.
+	template <utf8::detail::viewable_range_of<char> R>
+	constexpr auto operator()(R &&arg) const
+	{
+		return (*this)(std::forward<R>(arg) |
+			       std::views::transform([](char c) { return std::bit_cast<char8_t>(c); }));
+	}
+};
+
 } // namespace views::detail
 
 namespace views {
 
 constexpr inline detail::decode decode{};
+constexpr inline detail::to_utf16 to_utf16{};
+constexpr inline detail::encode encode{};
+constexpr inline detail::from_utf16 from_utf16{};
+constexpr inline detail::transcode<char16_t> utf8_to_utf16{};
+constexpr inline detail::transcode<char32_t> utf8_to_utf32{};
 
 } // namespace views
 
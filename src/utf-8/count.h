@@ -0,0 +1,66 @@
+#pragma once
+
+#include "utf-8/decoder.h"
+#include "utf-8/detail/dispatch.h"
+#include "utf-8/detail/scalar.h"
+
+#include <cstddef>
+#include <span>
+
+namespace utf8 {
+
+/// @brief Count the code points of a contiguous UTF-8 sequence, without decoding it
+///
+/// @param bytes The UTF-8 sequence
+///
+/// @return The number of code points utf8::decoder would produce, including replacement characters for errors
+///
+/// @note At run time, valid parts of the sequence are counted 64 bytes at a time, as their bytes which are not
+/// continuation bytes, with the most capable of SSE4.2, AVX2 and AVX-512 that the CPU supports. Only the parts which
+/// are not valid are run through the decoder.
+constexpr auto count_code_points(std::span<const char8_t> bytes) -> std::size_t
+{
+	std::size_t consumed{};
+	std::size_t count{};
+	decoder state{};
+
+	// Bytes from there are decoded one at a time, since the bulk kernels made no progress on them.
+	std::size_t fallback_end{};
+
+	while (consumed < bytes.size()) {
+		// At character boundaries, the bulk kernels count as much as they can.
+		if (consumed >= fallback_end and not state.check_last_error().has_value()) {
+			detail::transcode_result result{};
+			std::size_t window = 1;
+			if consteval {
+				result = detail::scalar::count_code_points(bytes.subspan(consumed));
+			} else {
+				const auto &kernels = detail::active_kernels();
+				result = kernels.count_code_points(bytes.subspan(consumed));
+				window = kernels.window;
+			}
+
+			consumed += result.consumed;
+			count += result.produced;
+			if (result.consumed != 0) {
+				continue;
+			}
+			fallback_end = consumed + window;
+		}
+
+		if (state.decode(bytes[consumed++]).has_value()) {
+			++count;
+			if (state.fetch().has_value()) {
+				++count;
+			}
+		}
+	}
+
+	if (state.check_last_error().has_value()) {
+		++count;
+	}
+
+	return count;
+}
+
+} // namespace utf8
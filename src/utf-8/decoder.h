@@ -85,12 +85,41 @@ class decoder {
 	    state::error, state::error, state::error, state::error, state::error, state::error, // state::next7
 	};
 
-	unsigned long code_{};
-	state state_{state::start};
+	enum class to_deliver : uint8_t { nothing, code_point, error };
 
-	enum class to_deliver { nothing, code_point, error };
+	// The whole state is packed in one word, since decoders may be kept by the million, e.g. one per connection,
+	// and since decoding loops then keep it in a single register: the FSM state in the lowest four bits, which
+	// every byte reads first, then what fetch shall deliver, then the code point built so far, on at most 21 bits.
+	// The code point is not kept once delivered, so a decoder at the start state with nothing to deliver is zero.
+	static constexpr auto to_deliver_shift_ = 4;
+	static constexpr auto code_shift_ = 8;
+	static constexpr uint32_t state_mask_ = 0xf;
+	static constexpr uint32_t to_deliver_mask_ = 0x3;
 
-	to_deliver to_deliver_{};
+	uint32_t word_{};
+
+	/// @brief Pack a state into a word
+	///
+	/// @param code The code point built so far, on at most 21 bits
+	/// @param s The FSM state
+	/// @param deliver What fetch shall deliver
+	///
+	/// @return The word
+	constexpr static auto pack(uint32_t code, state s, to_deliver deliver) -> uint32_t
+	{
+		return (code << code_shift_) | static_cast<uint32_t>(s) |
+		       (static_cast<uint32_t>(deliver) << to_deliver_shift_);
+	}
+
+	[[nodiscard]] constexpr auto current_code() const -> uint32_t { return word_ >> code_shift_; }
+	[[nodiscard]] constexpr auto current_state() const -> state
+	{
+		return static_cast<state>(word_ & state_mask_);
+	}
+	[[nodiscard]] constexpr auto pending_delivery() const -> to_deliver
+	{
+		return static_cast<to_deliver>((word_ >> to_deliver_shift_) & to_deliver_mask_);
+	}
 
 	/// @brief Calculate next state
 	///
@@ -115,6 +144,11 @@ class decoder {
 		return byte & (byte_mask >> type);
 	}
 
+	// The validator runs this exact FSM, without building code points, and the shift decoder runs it with another
+	// representation.
+	friend class validator;
+	friend class shift_decoder;
+
 public:
 	/// @brief Decode one byte
 	///
@@ -132,38 +166,36 @@ public:
 		static constexpr auto data_mask = 0x3f;
 		static constexpr auto data_shift = 6;
 
-		to_deliver_ = to_deliver::nothing;
-
-		const auto new_state = next_state(state_, type);
+		const auto current = current_state();
+		const auto new_state = next_state(current, type);
 
 		if (new_state == state::error) {
-			if (state_ == state::start) { // single byte in error
+			if (current == state::start) { // single byte in error
+				word_ = pack(0, state::start, to_deliver::nothing);
 				return replacement_char_;
 			}
-			state_ = next_state(state::start, type);
-			switch (state_) {
+			const auto resumed = next_state(state::start, type);
+			switch (resumed) {
 			case state::error: // interruption by byte in error
-				state_ = state::start;
-				to_deliver_ = to_deliver::error;
+				word_ = pack(0, state::start, to_deliver::error);
 				return replacement_char_;
 			case state::start: // interruption by single-byte code point
-				code_ = start_byte_payload(byte, type);
-				to_deliver_ = to_deliver::code_point;
+				word_ = pack(start_byte_payload(byte, type), state::start, to_deliver::code_point);
 				return replacement_char_;
 			default: // interruption by multi-byte start byte
-				code_ = start_byte_payload(byte, type);
+				word_ = pack(start_byte_payload(byte, type), resumed, to_deliver::nothing);
 				return replacement_char_;
 			}
 		}
 
-		code_ = (state_ == state::start) ? start_byte_payload(byte, type)
-						 : (code_ << data_shift) | (byte & data_mask);
-		state_ = new_state;
-
-		if (state_ == state::start) {
-			return code_;
+		const auto code = (current == state::start) ? start_byte_payload(byte, type)
+							    : (current_code() << data_shift) | (byte & data_mask);
+		if (new_state == state::start) {
+			word_ = pack(0, state::start, to_deliver::nothing);
+			return code;
 		}
 
+		word_ = pack(code, new_state, to_deliver::nothing);
 		return {};
 	}
 
@@ -172,11 +204,16 @@ public:
 	/// @return An extra decoded code point if there is one or nothing otherwise
 	constexpr auto fetch() -> std::optional<unsigned long>
 	{
-		const auto code = to_deliver_ == to_deliver::code_point ? std::optional{code_}
-				  : to_deliver_ == to_deliver::error	? std::optional{replacement_char_}
-									: std::nullopt;
-
-		to_deliver_ = to_deliver::nothing;
+		const auto deliver = pending_delivery();
+		const auto code = deliver == to_deliver::code_point ? std::optional<unsigned long>{current_code()}
+				  : deliver == to_deliver::error     ? std::optional{replacement_char_}
+								     : std::nullopt;
+
+		// Something is only left to deliver at the start state, to which the decoder then gets back, as if the
+		// code point had been returned by decode.
+		if (deliver != to_deliver::nothing) {
+			word_ = pack(0, state::start, to_deliver::nothing);
+		}
 		return code;
 	}
 
@@ -191,7 +228,7 @@ public:
 	/// preventing it is not either really necessary.
 	[[nodiscard]] constexpr auto check_last_error() const -> std::optional<unsigned long>
 	{
-		return state_ != state::start ? std::optional{replacement_char_} : std::nullopt;
+		return current_state() != state::start ? std::optional{replacement_char_} : std::nullopt;
 	}
 };
 
@@ -0,0 +1,673 @@
+#pragma once
+
+#include "utf-8/detail/cpu.h"
+
+#if defined(UTF_8_DETAIL_X86)
+
+#include "utf-8/detail/lookup.h"
+#include "utf-8/detail/scalar.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <span>
+
+#include <immintrin.h>
+
+// AVX2 kernels, processing 32 bytes at a time.
+
+namespace utf8::detail::avx2 {
+
+UTF_8_DETAIL_TARGET("avx2") inline auto load_table(const std::array<uint8_t, 16> &table) -> __m256i
+{
+	return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(table.data())));
+}
+
+/// @brief Shift a block right by N bytes, shifting in the last bytes of the previous block
+template <int N>
+UTF_8_DETAIL_TARGET("avx2") inline auto prev(__m256i input, __m256i prev_input) -> __m256i
+{
+	return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev_input, input, 0x21), 16 - N);
+}
+
+/// @brief Look for errors in a block
+///
+/// @param input The block
+/// @param prev_input The previous block, or zeros at the beginning of the sequence
+///
+/// @return Non-zero bytes at the positions of errors
+UTF_8_DETAIL_TARGET("avx2") inline auto check_block(__m256i input, __m256i prev_input) -> __m256i
+{
+	const auto nibble_mask = _mm256_set1_epi8(0x0f);
+
+	const auto prev1 = prev<1>(input, prev_input);
+	const auto byte_1_high = _mm256_shuffle_epi8(load_table(lookup::byte_1_high),
+						     _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble_mask));
+	const auto byte_1_low =
+	    _mm256_shuffle_epi8(load_table(lookup::byte_1_low), _mm256_and_si256(prev1, nibble_mask));
+	const auto byte_2_high = _mm256_shuffle_epi8(load_table(lookup::byte_2_high),
+						     _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble_mask));
+	const auto special_cases = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+	const auto third_byte = _mm256_set1_epi8(lookup::third_byte_threshold);
+	const auto fourth_byte = _mm256_set1_epi8(lookup::fourth_byte_threshold);
+	const auto must_be_continuation = _mm256_or_si256(_mm256_subs_epu8(prev<2>(input, prev_input), third_byte),
+							  _mm256_subs_epu8(prev<3>(input, prev_input), fourth_byte));
+
+	return _mm256_xor_si256(_mm256_and_si256(must_be_continuation, _mm256_set1_epi8(static_cast<char>(0x80))),
+				special_cases);
+}
+
+/// @brief Check whether a block ends in the middle of a character
+///
+/// @param input The block
+///
+/// @return Non-zero bytes at the positions of start bytes whose character does not end within the block
+UTF_8_DETAIL_TARGET("avx2") inline auto is_incomplete(__m256i input) -> __m256i
+{
+	static constexpr auto any = static_cast<char>(0xff);
+	return _mm256_subs_epu8(input, _mm256_setr_epi8(any, any, any, any, any, any, any, any, any, any, any, any, any,
+							any, any, any, any, any, any, any, any, any, any, any, any, any,
+							any, any, any, static_cast<char>(lookup::max_third_last_byte),
+							static_cast<char>(lookup::max_second_last_byte),
+							static_cast<char>(lookup::max_last_byte)));
+}
+
+/// @brief Load a block which may extend beyond the end of the sequence
+///
+/// @param data The beginning of the block
+/// @param size The number of bytes left in the sequence
+///
+/// @return The block, padded with zeros if needed
+UTF_8_DETAIL_TARGET("avx2") inline auto load_block(const char8_t *data, std::size_t size) -> __m256i
+{
+	if (size >= sizeof(__m256i)) {
+		return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+	}
+
+	std::array<char8_t, sizeof(__m256i)> block{};
+	std::memcpy(block.data(), data, size);
+	return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block.data()));
+}
+
+UTF_8_DETAIL_TARGET("avx2") inline auto validate(std::span<const char8_t> bytes) -> bool
+{
+	auto error = _mm256_setzero_si256();
+	auto prev_input = _mm256_setzero_si256();
+	auto prev_incomplete = _mm256_setzero_si256();
+
+	// Zero padding is ASCII, so it terminates the sequence like its actual end would.
+	for (std::size_t offset = 0; offset < bytes.size(); offset += sizeof(__m256i)) {
+		const auto input = load_block(bytes.data() + offset, bytes.size() - offset);
+
+		if (_mm256_movemask_epi8(input) == 0) {
+			error = _mm256_or_si256(error, prev_incomplete);
+			prev_incomplete = _mm256_setzero_si256();
+		} else {
+			error = _mm256_or_si256(error, check_block(input, prev_input));
+			prev_incomplete = is_incomplete(input);
+		}
+		prev_input = input;
+	}
+
+	error = _mm256_or_si256(error, prev_incomplete);
+
+	return _mm256_testz_si256(error, error) != 0;
+}
+
+/// @brief Decode the characters starting at eight consecutive positions, assuming valid UTF-8
+///
+/// @param window The bytes from the first position, of which the first eleven are used
+///
+/// @return The code points, in 32-bit lanes, meaningless for positions of continuation bytes
+UTF_8_DETAIL_TARGET("avx2") inline auto decode_lanes(__m128i window) -> __m256i
+{
+	// Every lane gets the four bytes starting at its position, first byte lowest.
+	const auto positions = _mm256_setr_epi8(0, 1, 2, 3, 1, 2, 3, 4, 2, 3, 4, 5, 3, 4, 5, 6, 4, 5, 6, 7, 5, 6, 7, 8,
+						6, 7, 8, 9, 7, 8, 9, 10);
+	const auto lanes = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(window), positions);
+
+	const auto data_mask = _mm256_set1_epi32(0x3f);
+	const auto byte0 = _mm256_and_si256(lanes, _mm256_set1_epi32(0xff));
+	const auto data1 = _mm256_and_si256(_mm256_srli_epi32(lanes, 8), data_mask);
+	const auto data2 = _mm256_and_si256(_mm256_srli_epi32(lanes, 16), data_mask);
+	const auto data3 = _mm256_and_si256(_mm256_srli_epi32(lanes, 24), data_mask);
+
+	const auto two = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(byte0, _mm256_set1_epi32(0x1f)), 6), data1);
+	const auto three =
+	    _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(byte0, _mm256_set1_epi32(0x0f)), 12),
+			    _mm256_or_si256(_mm256_slli_epi32(data1, 6), data2));
+	const auto four = _mm256_or_si256(
+	    _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(byte0, _mm256_set1_epi32(0x07)), 18),
+			    _mm256_slli_epi32(data1, 12)),
+	    _mm256_or_si256(_mm256_slli_epi32(data2, 6), data3));
+
+	auto code_points = _mm256_blendv_epi8(four, three, _mm256_cmpgt_epi32(_mm256_set1_epi32(0xf0), byte0));
+	code_points = _mm256_blendv_epi8(code_points, two, _mm256_cmpgt_epi32(_mm256_set1_epi32(0xe0), byte0));
+	return _mm256_blendv_epi8(code_points, byte0, _mm256_cmpgt_epi32(_mm256_set1_epi32(0x80), byte0));
+}
+
+/// @brief Transcode valid UTF-8 into UTF-32
+///
+/// @param data The UTF-8 sequence, starting at a character boundary, readable 16 bytes beyond its end
+/// @param size The size of the sequence, ending at a character boundary
+/// @param out The output, writable 8 code points beyond the last produced one
+///
+/// @return The number of code points produced
+UTF_8_DETAIL_TARGET("avx2") inline auto transcode_valid(const char8_t *data, std::size_t size, char32_t *out)
+    -> std::size_t
+{
+	static constexpr auto step = 8U;
+	static constexpr auto all_lanes = (1U << step) - 1;
+	static constexpr auto min_start_byte = static_cast<char>(0xc0 - 1);
+
+	std::size_t produced{};
+
+	for (std::size_t offset = 0; offset < size; offset += step) {
+		const auto window = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + offset));
+		const auto code_points = decode_lanes(window);
+
+		// Only lanes of ASCII and start bytes, in the sequence, hold a code point.
+		const auto is_first_byte = _mm_cmpgt_epi8(window, _mm_set1_epi8(min_start_byte));
+		const auto in_sequence = size - offset >= step ? all_lanes : (1U << (size - offset)) - 1;
+		const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(is_first_byte)) & in_sequence;
+
+		const auto indices = _mm256_cvtepu8_epi32(
+		    _mm_loadl_epi64(reinterpret_cast<const __m128i *>(lookup::compress_8x32.at(mask).data())));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + produced),
+				    _mm256_permutevar8x32_epi32(code_points, indices));
+		produced += static_cast<std::size_t>(std::popcount(mask));
+	}
+
+	return produced;
+}
+
+/// @brief Check whether a transcoding window is ASCII
+UTF_8_DETAIL_TARGET("avx2") inline auto is_ascii_window(const char8_t *data) -> bool
+{
+	const auto first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+	const auto second = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + sizeof(__m256i)));
+
+	return _mm256_movemask_epi8(_mm256_or_si256(first, second)) == 0;
+}
+
+/// @brief Check whether a transcoding window, starting at a character boundary, is valid
+///
+/// @note Any character starting in the window, but not ending in it, is not checked, but left for the next window.
+UTF_8_DETAIL_TARGET("avx2") inline auto is_valid_window(const char8_t *data) -> bool
+{
+	const auto first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+	const auto second = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + sizeof(__m256i)));
+	const auto error = _mm256_or_si256(check_block(first, _mm256_setzero_si256()), check_block(second, first));
+
+	return _mm256_testz_si256(error, error) != 0;
+}
+
+/// @brief Encode code points into UTF-16
+///
+/// @param code_points The code points, readable 16 code points beyond the last one
+/// @param count The number of code points
+/// @param out The output, writable 16 code units beyond the last produced one
+///
+/// @return The number of code units produced
+UTF_8_DETAIL_TARGET("avx2") inline auto narrow_to_utf16(const char32_t *code_points, std::size_t count, char16_t *out)
+    -> std::size_t
+{
+	static constexpr std::size_t step = 16;
+	static constexpr auto in_order = 0xd8; // Lane order of packed 64-bit elements: 0, 2, 1, 3
+
+	std::size_t produced{};
+
+	for (std::size_t i = 0; i < count; i += step) {
+		const auto low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(code_points + i));
+		const auto high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(code_points + i + step / 2));
+		const auto last_bmp = _mm256_set1_epi32(0xffff);
+		const auto supplementary =
+		    _mm256_or_si256(_mm256_cmpgt_epi32(low, last_bmp), _mm256_cmpgt_epi32(high, last_bmp));
+		const auto size = std::min(step, count - i);
+
+		// Surrogate pairs are rare enough for their group of code points to be encoded one at a time.
+		if (_mm256_testz_si256(supplementary, supplementary) != 0) {
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + produced),
+					    _mm256_permute4x64_epi64(_mm256_packus_epi32(low, high), in_order));
+			produced += size;
+		} else {
+			for (std::size_t j = 0; j < size; ++j) {
+				produced += encode_utf16(code_points[i + j], out + produced);
+			}
+		}
+	}
+
+	return produced;
+}
+
+UTF_8_DETAIL_TARGET("avx2") inline auto to_utf32(std::span<const char8_t> bytes, char32_t *out) -> transcode_result
+{
+	static constexpr auto lookahead = sizeof(__m128i);
+
+	transcode_result result{};
+
+	while (bytes.size() - result.consumed >= kernel_window + lookahead) {
+		const auto *data = bytes.data() + result.consumed;
+
+		if (is_ascii_window(data)) {
+			for (std::size_t offset = 0; offset < kernel_window; offset += sizeof(uint64_t)) {
+				const auto bytes_8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(data + offset));
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + result.produced + offset),
+						    _mm256_cvtepu8_epi32(bytes_8));
+			}
+			result.consumed += kernel_window;
+			result.produced += kernel_window;
+			continue;
+		}
+
+		if (not is_valid_window(data)) {
+			break;
+		}
+
+		const auto size = scalar::complete_prefix({data, kernel_window});
+		result.produced += transcode_valid(data, size, out + result.produced);
+		result.consumed += size;
+	}
+
+	// The rest of the sequence, or the window in error, may still begin with ASCII.
+	const auto ascii = scalar::to_utf32(bytes.subspan(result.consumed), out + result.produced);
+	result.consumed += ascii.consumed;
+	result.produced += ascii.produced;
+
+	return result;
+}
+
+UTF_8_DETAIL_TARGET("avx2") inline auto to_utf16(std::span<const char8_t> bytes, char16_t *out) -> transcode_result
+{
+	static constexpr auto lookahead = sizeof(__m128i);
+
+	transcode_result result{};
+	// Encoding into UTF-16 reads whole steps of code points.
+	std::array<char32_t, kernel_window + sizeof(__m256i) / 2> code_points{};
+
+	while (bytes.size() - result.consumed >= kernel_window + lookahead) {
+		const auto *data = bytes.data() + result.consumed;
+
+		if (is_ascii_window(data)) {
+			for (std::size_t offset = 0; offset < kernel_window; offset += sizeof(__m128i)) {
+				const auto bytes_16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + offset));
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + result.produced + offset),
+						    _mm256_cvtepu8_epi16(bytes_16));
+			}
+			result.consumed += kernel_window;
+			result.produced += kernel_window;
+			continue;
+		}
+
+		if (not is_valid_window(data)) {
+			break;
+		}
+
+		const auto size = scalar::complete_prefix({data, kernel_window});
+		const auto count = transcode_valid(data, size, code_points.data());
+		result.produced += narrow_to_utf16(code_points.data(), count, out + result.produced);
+		result.consumed += size;
+	}
+
+	const auto ascii = scalar::to_utf16(bytes.subspan(result.consumed), out + result.produced);
+	result.consumed += ascii.consumed;
+	result.produced += ascii.produced;
+
+	return result;
+}
+
+UTF_8_DETAIL_TARGET("avx2") inline auto count_code_points(std::span<const char8_t> bytes) -> transcode_result
+{
+	static constexpr auto max_continuation_byte = static_cast<char>(0xbf);
+
+	transcode_result result{};
+
+	while (bytes.size() - result.consumed >= kernel_window) {
+		const auto *data = bytes.data() + result.consumed;
+
+		if (is_ascii_window(data)) {
+			result.consumed += kernel_window;
+			result.produced += kernel_window;
+			continue;
+		}
+
+		if (not is_valid_window(data)) {
+			break;
+		}
+
+		// Every byte but the continuation bytes starts a code point, including the one of an incomplete
+		// character at the end of the window, which is left for the next window.
+		std::size_t count{};
+		for (std::size_t offset = 0; offset < kernel_window; offset += sizeof(__m256i)) {
+			const auto input = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + offset));
+			const auto is_first_byte = _mm256_cmpgt_epi8(input, _mm256_set1_epi8(max_continuation_byte));
+			const auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(is_first_byte));
+			count += static_cast<std::size_t>(std::popcount(mask));
+		}
+		const auto size = scalar::complete_prefix({data, kernel_window});
+		result.consumed += size;
+		result.produced += count - (size != kernel_window ? 1 : 0);
+	}
+
+	const auto ascii = scalar::count_code_points(bytes.subspan(result.consumed));
+	result.consumed += ascii.consumed;
+	result.produced += ascii.produced;
+
+	return result;
+}
+
+/// @brief Replace the values which are not Unicode scalar values by U+FFFD
+UTF_8_DETAIL_TARGET("avx2") inline auto scalar_values(__m256i code_points) -> __m256i
+{
+	// Beyond U+10FFFF, values are saturated first, since comparisons are signed.
+	const auto beyond = _mm256_set1_epi32(0x110000);
+	const auto saturated = _mm256_min_epu32(code_points, beyond);
+	const auto invalid = _mm256_or_si256(
+	    _mm256_cmpeq_epi32(saturated, beyond),
+	    _mm256_cmpeq_epi32(_mm256_and_si256(saturated, _mm256_set1_epi32(~0x7ff)), _mm256_set1_epi32(0xd800)));
+
+	return _mm256_blendv_epi8(saturated, _mm256_set1_epi32(0xfffd), invalid);
+}
+
+/// @brief Encode eight code points into UTF-8
+///
+/// @param code_points The code points
+/// @param out The output, writable 32 bytes from the beginning
+///
+/// @return The number of bytes produced
+UTF_8_DETAIL_TARGET("avx2") inline auto encode_lanes(__m256i code_points, char8_t *out) -> std::size_t
+{
+	static constexpr auto half_lanes = 4U;
+	static constexpr auto half_mask = (1U << half_lanes) - 1;
+
+	const auto code = scalar_values(code_points);
+
+	// Every lane gets the encodings of its code point on two, three and four bytes, first byte lowest.
+	const auto data_mask = _mm256_set1_epi32(0x3f);
+	const auto continuation = _mm256_set1_epi32(0x80);
+	const auto data0 = _mm256_or_si256(_mm256_and_si256(code, data_mask), continuation);
+	const auto data1 = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(code, 6), data_mask), continuation);
+	const auto data2 = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(code, 12), data_mask), continuation);
+
+	const auto two = _mm256_or_si256(_mm256_or_si256(_mm256_srli_epi32(code, 6), _mm256_set1_epi32(0xc0)),
+					 _mm256_slli_epi32(data0, 8));
+	const auto three = _mm256_or_si256(_mm256_or_si256(_mm256_srli_epi32(code, 12), _mm256_set1_epi32(0xe0)),
+					   _mm256_or_si256(_mm256_slli_epi32(data1, 8), _mm256_slli_epi32(data0, 16)));
+	const auto four = _mm256_or_si256(
+	    _mm256_or_si256(_mm256_srli_epi32(code, 18), _mm256_set1_epi32(0xf0)),
+	    _mm256_or_si256(_mm256_slli_epi32(data2, 8),
+			    _mm256_or_si256(_mm256_slli_epi32(data1, 16), _mm256_slli_epi32(data0, 24))));
+
+	const auto is_multi_byte = _mm256_cmpgt_epi32(code, _mm256_set1_epi32(0x7f));
+	const auto is_three_byte = _mm256_cmpgt_epi32(code, _mm256_set1_epi32(0x7ff));
+	const auto is_four_byte = _mm256_cmpgt_epi32(code, _mm256_set1_epi32(0xffff));
+
+	auto encoded = _mm256_blendv_epi8(code, two, is_multi_byte);
+	encoded = _mm256_blendv_epi8(encoded, three, is_three_byte);
+	encoded = _mm256_blendv_epi8(encoded, four, is_four_byte);
+
+	// Every mask adds one byte to the length of its lanes. Byte shuffles stay within 128-bit halves, which are
+	// compressed independently.
+	const auto multi_byte = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(is_multi_byte)));
+	const auto three_byte = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(is_three_byte)));
+	const auto four_byte = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(is_four_byte)));
+	const auto lengths = [&](unsigned int shift) {
+		return lookup::spread_4x2.at((multi_byte >> shift) & half_mask) +
+		       lookup::spread_4x2.at((three_byte >> shift) & half_mask) +
+		       lookup::spread_4x2.at((four_byte >> shift) & half_mask);
+	};
+	const auto shuffle = _mm256_inserti128_si256(
+	    _mm256_castsi128_si256(
+		_mm_loadu_si128(reinterpret_cast<const __m128i *>(lookup::encode_4x32.at(lengths(0)).data()))),
+	    _mm_loadu_si128(reinterpret_cast<const __m128i *>(lookup::encode_4x32.at(lengths(half_lanes)).data())), 1);
+	const auto compressed = _mm256_shuffle_epi8(encoded, shuffle);
+
+	const auto low_size = static_cast<std::size_t>(half_lanes) +
+			      static_cast<std::size_t>(std::popcount(multi_byte & half_mask) +
+						       std::popcount(three_byte & half_mask) +
+						       std::popcount(four_byte & half_mask));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm256_castsi256_si128(compressed));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out + low_size), _mm256_extracti128_si256(compressed, 1));
+
+	return 2 * half_lanes + static_cast<std::size_t>(std::popcount(multi_byte) + std::popcount(three_byte) +
+							 std::popcount(four_byte));
+}
+
+/// @brief Encode sixteen code points below U+0800 into UTF-8
+///
+/// @param code_points The code points, in 16-bit lanes
+/// @param out The output, writable 32 bytes from the beginning
+///
+/// @return The number of bytes produced
+UTF_8_DETAIL_TARGET("avx2") inline auto encode_two_byte_lanes(__m256i code_points, char8_t *out) -> std::size_t
+{
+	static constexpr auto half_lanes = 8U;
+	static constexpr auto half_mask = (1U << half_lanes) - 1;
+
+	const auto is_ascii = _mm256_cmpgt_epi16(_mm256_set1_epi16(0x80), code_points);
+	const auto first = _mm256_or_si256(_mm256_srli_epi16(code_points, 6), _mm256_set1_epi16(0xc0));
+	const auto second =
+	    _mm256_or_si256(_mm256_and_si256(code_points, _mm256_set1_epi16(0x3f)), _mm256_set1_epi16(0x80));
+	const auto encoded =
+	    _mm256_blendv_epi8(_mm256_or_si256(first, _mm256_slli_epi16(second, 8)), code_points, is_ascii);
+
+	// Packing within 128-bit halves leaves the mask of each half in a byte of its own.
+	const auto single =
+	    static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_packs_epi16(is_ascii, _mm256_setzero_si256())));
+	const auto low = single & half_mask;
+	const auto high = (single >> (2 * half_lanes)) & half_mask;
+	const auto *low_table = lookup::encode_8x16.at(low).data();
+	const auto *high_table = lookup::encode_8x16.at(high).data();
+	const auto low_shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i *>(low_table));
+	const auto high_shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i *>(high_table));
+	const auto shuffle = _mm256_inserti128_si256(_mm256_castsi128_si256(low_shuffle), high_shuffle, 1);
+	const auto compressed = _mm256_shuffle_epi8(encoded, shuffle);
+
+	const auto low_size = 2 * half_lanes - static_cast<std::size_t>(std::popcount(low));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm256_castsi256_si128(compressed));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out + low_size), _mm256_extracti128_si256(compressed, 1));
+
+	return low_size + 2 * half_lanes - static_cast<std::size_t>(std::popcount(high));
+}
+
+UTF_8_DETAIL_TARGET("avx2") inline auto from_utf32(std::span<const char32_t> code_points, std::span<char8_t> out)
+    -> transcode_result
+{
+	static constexpr std::size_t step = sizeof(__m256i) / sizeof(char32_t);
+	static constexpr std::size_t block = 4 * step;
+	// A block produces at most four bytes per code point, and every store writes a whole vector within them.
+	static constexpr std::size_t max_block_bytes = 4 * block;
+
+	transcode_result result{};
+
+	while (code_points.size() - result.consumed >= block and out.size() - result.produced >= max_block_bytes) {
+		const auto *data = reinterpret_cast<const __m256i *>(code_points.data() + result.consumed);
+		const auto first = _mm256_loadu_si256(data);
+		const auto second = _mm256_loadu_si256(data + 1);
+		const auto third = _mm256_loadu_si256(data + 2);
+		const auto fourth = _mm256_loadu_si256(data + 3);
+
+		const auto any = _mm256_or_si256(_mm256_or_si256(first, second), _mm256_or_si256(third, fourth));
+		if (_mm256_testz_si256(any, _mm256_set1_epi32(~0x7f)) != 0) {
+			// Packing works within 128-bit halves, hence the final permutation.
+			const auto packed = _mm256_packus_epi16(_mm256_packus_epi32(first, second),
+								_mm256_packus_epi32(third, fourth));
+			const auto order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(out.data() + result.produced),
+					    _mm256_permutevar8x32_epi32(packed, order));
+			result.produced += block;
+		} else if (_mm256_testz_si256(any, _mm256_set1_epi32(~0x7ff)) != 0) {
+			// Below U+0800, code points fit in 16-bit lanes, twice as many at a time.
+			static constexpr auto in_order = 0xd8;
+			result.produced += encode_two_byte_lanes(
+			    _mm256_permute4x64_epi64(_mm256_packus_epi32(first, second), in_order),
+			    out.data() + result.produced);
+			result.produced += encode_two_byte_lanes(
+			    _mm256_permute4x64_epi64(_mm256_packus_epi32(third, fourth), in_order),
+			    out.data() + result.produced);
+		} else {
+			for (const auto code : {first, second, third, fourth}) {
+				result.produced += encode_lanes(code, out.data() + result.produced);
+			}
+		}
+		result.consumed += block;
+	}
+
+	const auto rest = scalar::from_utf32(code_points.subspan(result.consumed), out.subspan(result.produced));
+	result.consumed += rest.consumed;
+	result.produced += rest.produced;
+
+	return result;
+}
+
+UTF_8_DETAIL_TARGET("avx2") inline auto encoded_length(std::span<const char32_t> code_points) -> std::size_t
+{
+	static constexpr std::size_t step = sizeof(__m256i) / sizeof(char32_t);
+	// Lanes count at most three extra bytes per code point, and are summed before they could overflow.
+	static constexpr std::size_t chunk = std::size_t{1} << 24U;
+
+	std::size_t offset{};
+	std::size_t length{};
+
+	while (code_points.size() - offset >= step) {
+		const auto end = offset + std::min(chunk, (code_points.size() - offset) / step * step);
+		auto extra = _mm256_setzero_si256();
+
+		for (; offset < end; offset += step) {
+			const auto code = scalar_values(
+			    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(code_points.data() + offset)));
+			extra = _mm256_sub_epi32(extra, _mm256_cmpgt_epi32(code, _mm256_set1_epi32(0x7f)));
+			extra = _mm256_sub_epi32(extra, _mm256_cmpgt_epi32(code, _mm256_set1_epi32(0x7ff)));
+			extra = _mm256_sub_epi32(extra, _mm256_cmpgt_epi32(code, _mm256_set1_epi32(0xffff)));
+		}
+
+		auto sum = _mm_add_epi32(_mm256_castsi256_si128(extra), _mm256_extracti128_si256(extra, 1));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+		length += static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+	}
+
+	return offset + length + scalar::encoded_length(code_points.subspan(offset));
+}
+
+/// @brief Get the mask of the 16-bit lanes of a comparison result
+UTF_8_DETAIL_TARGET("avx2") inline auto lane_mask_16(__m256i comparison) -> unsigned int
+{
+	// Packing within 128-bit halves leaves the mask of each half in a byte of its own.
+	const auto mask =
+	    static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_packs_epi16(comparison, _mm256_setzero_si256())));
+	return (mask & 0xffU) | ((mask >> 8U) & 0xff00U);
+}
+
+/// @brief Encode eight UTF-16 code units into UTF-8, with surrogate pairs
+///
+/// @param units The code units, in 32-bit lanes
+/// @param next The code units which follow them, in 32-bit lanes
+/// @param pairs All ones in the lanes of code units which start a surrogate pair with the next one
+/// @param keep The mask of the lanes to encode, excluding the second halves of surrogate pairs
+/// @param out The output, writable 32 bytes from the beginning
+///
+/// @return The number of bytes produced
+UTF_8_DETAIL_TARGET("avx2") inline auto encode_surrogate_lanes(__m256i units, __m256i next, __m256i pairs,
+							       unsigned int keep, char8_t *out) -> std::size_t
+{
+	static constexpr auto lanes = 8U;
+	static constexpr auto surrogate_shift = 10;
+	static constexpr auto pair_offset = 0x10000 - (0xd800 << surrogate_shift) - 0xdc00;
+
+	// Unpaired surrogates are left as they are, for the encoding to replace them.
+	const auto combined = _mm256_add_epi32(_mm256_slli_epi32(units, surrogate_shift),
+					       _mm256_add_epi32(next, _mm256_set1_epi32(pair_offset)));
+	const auto code_points = _mm256_blendv_epi8(units, combined, pairs);
+
+	// The lanes beyond the kept ones are zeroed, so that they encode into as many zeros, after the kept ones.
+	const auto count = static_cast<unsigned int>(std::popcount(keep));
+	const auto indices = _mm256_cvtepu8_epi32(
+	    _mm_loadl_epi64(reinterpret_cast<const __m128i *>(lookup::compress_8x32.at(keep).data())));
+	const auto in_use = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(count)),
+					       _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	const auto compressed = _mm256_and_si256(_mm256_permutevar8x32_epi32(code_points, indices), in_use);
+
+	return encode_lanes(compressed, out) - (lanes - count);
+}
+
+UTF_8_DETAIL_TARGET("avx2") inline auto from_utf16(std::span<const char16_t> code_units, std::span<char8_t> out)
+    -> transcode_result
+{
+	static constexpr std::size_t block = sizeof(__m256i) / sizeof(char16_t);
+	static constexpr auto half_lanes = 8U;
+	// A block produces at most three bytes per code unit, and stores write less than a vector beyond them.
+	static constexpr std::size_t max_block_bytes = 3 * block + sizeof(__m256i);
+	// The code unit after a block is read too, in case the last one of the block starts a surrogate pair.
+	static constexpr std::size_t lookahead = 1;
+	static constexpr auto in_order = 0xd8;
+
+	transcode_result result{};
+
+	while (code_units.size() - result.consumed >= block + lookahead and
+	       out.size() - result.produced >= max_block_bytes) {
+		const auto *data = code_units.data() + result.consumed;
+		auto *output = out.data() + result.produced;
+		const auto units = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+
+		if (_mm256_testz_si256(units, _mm256_set1_epi16(static_cast<short>(0xff80))) != 0) {
+			const auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(units, units), in_order);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(output), _mm256_castsi256_si128(packed));
+			result.consumed += block;
+			result.produced += block;
+			continue;
+		}
+
+		if (_mm256_testz_si256(units, _mm256_set1_epi16(static_cast<short>(0xf800))) != 0) {
+			result.consumed += block;
+			result.produced += encode_two_byte_lanes(units, output);
+			continue;
+		}
+
+		const auto low_units = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(units));
+		const auto high_units = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(units, 1));
+		const auto high_surrogate = _mm256_set1_epi16(static_cast<short>(0xd800));
+		const auto low_surrogate = _mm256_set1_epi16(static_cast<short>(0xdc00));
+		const auto surrogate_mask = _mm256_set1_epi16(static_cast<short>(0xf800));
+		const auto surrogates = _mm256_cmpeq_epi16(_mm256_and_si256(units, surrogate_mask), high_surrogate);
+
+		if (_mm256_testz_si256(surrogates, surrogates) != 0) {
+			const auto size = encode_lanes(low_units, output);
+			result.produced += size + encode_lanes(high_units, output + size);
+			result.consumed += block;
+			continue;
+		}
+
+		// Pairs are found with the code units shifted by one. A high surrogate at the end of a block is left
+		// for the next one, where it gets its next code unit.
+		const auto next = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + 1));
+		const auto pair_mask = _mm256_set1_epi16(static_cast<short>(0xfc00));
+		const auto is_high = _mm256_cmpeq_epi16(_mm256_and_si256(units, pair_mask), high_surrogate);
+		const auto is_low = _mm256_cmpeq_epi16(_mm256_and_si256(next, pair_mask), low_surrogate);
+		const auto pairs = _mm256_and_si256(is_high, is_low);
+
+		const auto size = (lane_mask_16(is_high) >> (block - 1)) != 0 ? block - 1 : block;
+		const auto keep = ~(lane_mask_16(pairs) << 1U) & ((1U << size) - 1);
+
+		const auto low_size = encode_surrogate_lanes(
+		    low_units, _mm256_cvtepu16_epi32(_mm256_castsi256_si128(next)),
+		    _mm256_cvtepi16_epi32(_mm256_castsi256_si128(pairs)), keep & ((1U << half_lanes) - 1), output);
+		const auto high_size = encode_surrogate_lanes(
+		    high_units, _mm256_cvtepu16_epi32(_mm256_extracti128_si256(next, 1)),
+		    _mm256_cvtepi16_epi32(_mm256_extracti128_si256(pairs, 1)), keep >> half_lanes, output + low_size);
+		result.consumed += size;
+		result.produced += low_size + high_size;
+	}
+
+	const auto rest = scalar::from_utf16(code_units.subspan(result.consumed), out.subspan(result.produced));
+	result.consumed += rest.consumed;
+	result.produced += rest.produced;
+
+	return result;
+}
+
+} // namespace utf8::detail::avx2
+
+#endif
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "utf-8/detail/cpu.h"
+
+#if defined(UTF_8_DETAIL_X86)
+
+#include "utf-8/detail/lookup.h"
+#include "utf-8/detail/scalar.h"
+
+#include <array>
+#include <bit>
+#include <span>
+
+#include <immintrin.h>
+
+// AVX-512 (F and BW) kernels, processing 64 bytes at a time.
+
+#define UTF_8_DETAIL_AVX512 "avx512f,avx512bw"
+
+namespace utf8::detail::avx512 {
+
+UTF_8_DETAIL_TARGET(UTF_8_DETAIL_AVX512) inline auto load_table(const std::array<uint8_t, 16> &table) -> __m512i
+{
+	return _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const __m128i *>(table.data())));
+}
+
+/// @brief Shift a block right by N bytes, shifting in the last bytes of the previous block
+template <int N>
+UTF_8_DETAIL_TARGET(UTF_8_DETAIL_AVX512) inline auto prev(__m512i input, __m512i prev_input) -> __m512i
+{
+	static constexpr auto lane_shift = 6; // In 64-bit elements, i.e. three 128-bit lanes
+
+	return _mm512_alignr_epi8(input, _mm512_alignr_epi64(input, prev_input, lane_shift), 16 - N);
+}
+
+/// @brief Look for errors in a block
+///
+/// @param input The block
+/// @param prev_input The previous block, or zeros at the beginning of the sequence
+///
+/// @return Non-zero bytes at the positions of errors
+UTF_8_DETAIL_TARGET(UTF_8_DETAIL_AVX512) inline auto check_block(__m512i input, __m512i prev_input) -> __m512i
+{
+	const auto nibble_mask = _mm512_set1_epi8(0x0f);
+
+	const auto prev1 = prev<1>(input, prev_input);
+	const auto byte_1_high = _mm512_shuffle_epi8(load_table(lookup::byte_1_high),
+						     _mm512_and_si512(_mm512_srli_epi16(prev1, 4), nibble_mask));
+	const auto byte_1_low =
+	    _mm512_shuffle_epi8(load_table(lookup::byte_1_low), _mm512_and_si512(prev1, nibble_mask));
+	const auto byte_2_high = _mm512_shuffle_epi8(load_table(lookup::byte_2_high),
+						     _mm512_and_si512(_mm512_srli_epi16(input, 4), nibble_mask));
+	const auto special_cases = _mm512_and_si512(_mm512_and_si512(byte_1_high, byte_1_low), byte_2_high);
+
+	const auto third_byte = _mm512_set1_epi8(lookup::third_byte_threshold);
+	const auto fourth_byte = _mm512_set1_epi8(lookup::fourth_byte_threshold);
+	const auto must_be_continuation = _mm512_or_si512(_mm512_subs_epu8(prev<2>(input, prev_input), third_byte),
+							  _mm512_subs_epu8(prev<3>(input, prev_input), fourth_byte));
+
+	return _mm512_xor_si512(_mm512_and_si512(must_be_continuation, _mm512_set1_epi8(static_cast<char>(0x80))),
+				special_cases);
+}
+
+/// @brief Check whether a block ends in the middle of a character
+///
+/// @param input The block
+///
+/// @return Non-zero bytes at the positions of start bytes whose character does not end within the block
+UTF_8_DETAIL_TARGET(UTF_8_DETAIL_AVX512) inline auto is_incomplete(__m512i input) -> __m512i
+{
+	static constexpr auto last_byte = uint64_t{1} << 63U;
+
+	// All bytes but the last three are subtracted 0xff.
+	auto max = _mm512_mask_set1_epi8(_mm512_set1_epi8(static_cast<char>(0xff)), last_byte,
+					 static_cast<char>(lookup::max_last_byte));
+	max = _mm512_mask_set1_epi8(max, last_byte >> 1U, static_cast<char>(lookup::max_second_last_byte));
+	max = _mm512_mask_set1_epi8(max, last_byte >> 2U, static_cast<char>(lookup::max_third_last_byte));
+
+	return _mm512_subs_epu8(input, max);
+}
+
+/// @brief Load a block which may extend beyond the end of the sequence
+///
+/// @param data The beginning of the block
+/// @param size The number of bytes left in the sequence
+///
+/// @return The block, padded with zeros if needed
+UTF_8_DETAIL_TARGET(UTF_8_DETAIL_AVX512) inline auto load_block(const char8_t *data, std::size_t size) -> __m512i
+{
+	if (size >= sizeof(__m512i)) {
+		return _mm512_loadu_si512(data);
+	}
+
+	return _mm512_maskz_loadu_epi8(_cvtu64_mask64((uint64_t{1} << size) - 1), data);
+}
+
+UTF_8_DETAIL_TARGET(UTF_8_DETAIL_AVX512) inline auto validate(std::span<const char8_t> bytes) -> bool
+{
+	auto error = _mm512_setzero_si512();
+	auto prev_input = _mm512_setzero_si512();
+	auto prev_incomplete = _mm512_setzero_si512();
+
+	// Zero padding is ASCII, so it terminates the sequence like its actual end would.
+	for (std::size_t offset = 0; offset < bytes.size(); offset += sizeof(__m512i)) {
+		const auto input = load_block(bytes.data() + offset, bytes.size() - offset);
+
+		if (_mm512_movepi8_mask(input) == 0) {
+			error = _mm512_or_si512(error, prev_incomplete);
+			prev_incomplete = _mm512_setzero_si512();
+		} else {
+			error = _mm512_or_si512(error, check_block(input, prev_input));
+			prev_incomplete = is_incomplete(input);
+		}
+		prev_input = input;
+	}
+
+	error = _mm512_or_si512(error, prev_incomplete);
+
+	return _mm512_test_epi8_mask(error, error) == 0;
+}
+
+UTF_8_DETAIL_TARGET(UTF_8_DETAIL_AVX512) inline auto count_code_points(std::span<const char8_t> bytes)
+    -> transcode_result
+{
+	static constexpr auto max_continuation_byte = static_cast<char>(0xbf);
+	static_assert(kernel_window == sizeof(__m512i));
+
+	transcode_result result{};
+
+	while (bytes.size() - result.consumed >= kernel_window) {
+		const auto *data = bytes.data() + result.consumed;
+		const auto input = _mm512_loadu_si512(data);
+
+		if (_mm512_movepi8_mask(input) == 0) {
+			result.consumed += kernel_window;
+			result.produced += kernel_window;
+			continue;
+		}
+
+		// Any character starting in the window, but not ending in it, is not checked, but left for the next
+		// window.
+		const auto error = check_block(input, _mm512_setzero_si512());
+		if (_mm512_test_epi8_mask(error, error) != 0) {
+			break;
+		}
+
+		// Every byte but the continuation bytes starts a code point, including the one of an incomplete
+		// character at the end of the window.
+		const auto count = static_cast<std::size_t>(
+		    std::popcount(_mm512_cmpgt_epi8_mask(input, _mm512_set1_epi8(max_continuation_byte))));
+		const auto size = scalar::complete_prefix({data, kernel_window});
+		result.consumed += size;
+		result.produced += count - (size != kernel_window ? 1 : 0);
+	}
+
+	const auto ascii = scalar::count_code_points(bytes.subspan(result.consumed));
+	result.consumed += ascii.consumed;
+	result.produced += ascii.produced;
+
+	return result;
+}
+
+} // namespace utf8::detail::avx512
+
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+
+// CPU feature detection, for the selection of kernels at run time.
+//
+// All kernels are compiled, whatever the compiler flags, with function-level target attributes, so that one binary
+// built for a baseline target still gets wide vector code on CPUs that support it.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define UTF_8_DETAIL_X86 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define UTF_8_DETAIL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define UTF_8_DETAIL_TARGET(isa)
+#endif
+
+#if defined(UTF_8_DETAIL_X86) and defined(_MSC_VER) and not defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace utf8::detail {
+
+/// @brief Instruction sets for which kernels exist, from the least to the most capable
+enum class isa { scalar, sse42, avx2, avx512 };
+
+/// @brief Check whether the running CPU (and operating system) support an instruction set
+///
+/// @param set The instruction set
+///
+/// @return True if kernels for that instruction set may be run
+inline auto supports(isa set) -> bool
+{
+#if defined(UTF_8_DETAIL_X86) and (defined(__GNUC__) or defined(__clang__))
+	__builtin_cpu_init();
+	switch (set) {
+	case isa::scalar:
+		return true;
+	case isa::sse42:
+		return __builtin_cpu_supports("sse4.2") != 0;
+	case isa::avx2:
+		return __builtin_cpu_supports("avx2") != 0;
+	case isa::avx512:
+		return __builtin_cpu_supports("avx512f") != 0 and __builtin_cpu_supports("avx512bw") != 0;
+	}
+	return false;
+#elif defined(UTF_8_DETAIL_X86) and defined(_MSC_VER)
+	static constexpr auto sse42_bit = 1 << 20; // CPUID.1:ECX
+	static constexpr auto osxsave_bit = 1 << 27; // CPUID.1:ECX
+	static constexpr auto avx2_bit = 1 << 5; // CPUID.7.0:EBX
+	static constexpr auto avx512f_bit = 1 << 16; // CPUID.7.0:EBX
+	static constexpr auto avx512bw_bit = 1 << 30; // CPUID.7.0:EBX
+	static constexpr auto ymm_state = 0x6; // XCR0: SSE and AVX state
+	static constexpr auto zmm_state = 0xe6; // XCR0: SSE, AVX and AVX-512 state
+
+	int regs[4]{};
+	__cpuid(regs, 1);
+	const auto ecx1 = regs[2];
+	__cpuidex(regs, 7, 0);
+	const auto ebx7 = regs[1];
+	const auto xcr0 = (ecx1 & osxsave_bit) != 0 ? _xgetbv(0) : 0;
+
+	switch (set) {
+	case isa::scalar:
+		return true;
+	case isa::sse42:
+		return (ecx1 & sse42_bit) != 0;
+	case isa::avx2:
+		return (ebx7 & avx2_bit) != 0 and (xcr0 & ymm_state) == ymm_state;
+	case isa::avx512:
+		return (ebx7 & avx512f_bit) != 0 and (ebx7 & avx512bw_bit) != 0 and (xcr0 & zmm_state) == zmm_state;
+	}
+	return false;
+#else
+	return set == isa::scalar;
+#endif
+}
+
+} // namespace utf8::detail
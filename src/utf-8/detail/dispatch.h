@@ -0,0 +1,84 @@
+#pragma once
+
+#include "utf-8/detail/avx2.h"
+#include "utf-8/detail/avx512.h"
+#include "utf-8/detail/cpu.h"
+#include "utf-8/detail/scalar.h"
+#include "utf-8/detail/sse42.h"
+
+#include <cstddef>
+#include <span>
+
+namespace utf8::detail {
+
+/// @brief The bulk kernels for one instruction set
+struct kernels {
+	auto (*validate)(std::span<const char8_t> bytes) -> bool;
+	auto (*to_utf32)(std::span<const char8_t> bytes, char32_t *out) -> transcode_result;
+	auto (*to_utf16)(std::span<const char8_t> bytes, char16_t *out) -> transcode_result;
+	auto (*count_code_points)(std::span<const char8_t> bytes) -> transcode_result;
+	auto (*from_utf32)(std::span<const char32_t> code_points, std::span<char8_t> out) -> transcode_result;
+	auto (*encoded_length)(std::span<const char32_t> code_points) -> std::size_t;
+	auto (*from_utf16)(std::span<const char16_t> code_units, std::span<char8_t> out) -> transcode_result;
+	std::size_t window; ///< Number of bytes to decode without the kernels when they make no progress
+};
+
+/// @brief Get the kernels for an instruction set
+///
+/// @param set The instruction set
+///
+/// @return The kernels
+///
+/// @warning The running CPU must support the instruction set, see utf8::detail::supports.
+inline auto kernels_for(isa set) -> const kernels &
+{
+	static constexpr kernels scalar_kernels{&scalar::validate, &scalar::to_utf32, &scalar::to_utf16,
+						&scalar::count_code_points, &scalar::from_utf32,
+						&scalar::encoded_length, &scalar::from_utf16, 1};
+#if defined(UTF_8_DETAIL_X86)
+	// The vector encoding of UTF-16 relies on lane permutations, which SSE4.2 lacks.
+	static constexpr kernels sse42_kernels{&sse42::validate, &sse42::to_utf32, &sse42::to_utf16,
+					       &sse42::count_code_points, &sse42::from_utf32, &sse42::encoded_length,
+					       &scalar::from_utf16, kernel_window};
+	static constexpr kernels avx2_kernels{&avx2::validate, &avx2::to_utf32, &avx2::to_utf16,
+					      &avx2::count_code_points, &avx2::from_utf32, &avx2::encoded_length,
+					      &avx2::from_utf16, kernel_window};
+	// Transcoding is limited by the compression of code points, where AVX-512 brings nothing but wider lanes.
+	static constexpr kernels avx512_kernels{&avx512::validate, &avx2::to_utf32, &avx2::to_utf16,
+						&avx512::count_code_points, &avx2::from_utf32, &avx2::encoded_length,
+						&avx2::from_utf16, kernel_window};
+
+	switch (set) {
+	case isa::scalar:
+		break;
+	case isa::sse42:
+		return sse42_kernels;
+	case isa::avx2:
+		return avx2_kernels;
+	case isa::avx512:
+		return avx512_kernels;
+	}
+#else
+	static_cast<void>(set);
+#endif
+	return scalar_kernels;
+}
+
+/// @brief Get the kernels for the most capable instruction set supported by the running CPU
+///
+/// @return The kernels, selected once, on first invocation
+inline auto active_kernels() -> const kernels &
+{
+	static const kernels &active = [] -> const kernels & {
+		for (const auto set : {isa::avx512, isa::avx2, isa::sse42}) {
+			if (supports(set)) {
+				return kernels_for(set);
+			}
+		}
+		return kernels_for(isa::scalar);
+	}();
+
+	return active;
+}
+
+} // namespace utf8::detail
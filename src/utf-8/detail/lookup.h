@@ -0,0 +1,194 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Lookup tables for vectorized kernels.
+//
+// The first tables are for vectorized UTF-8 validation, as described by John Keiser and Daniel Lemire in "Validating
+// UTF-8 In Less Than One Instruction Per Byte" (https://arxiv.org/abs/2010.03090).
+//
+// Every pair of consecutive bytes is classified by three 16-entry tables, respectively indexed by the high nibble of
+// the first byte, the low nibble of the first byte and the high nibble of the second byte. Each table entry is a set
+// of error bits, and the pair is in error if the three sets intersect. The only errors that cannot be detected from
+// pairs are missing or extra continuation bytes after three and four-byte start bytes, which are checked separately
+// with the two previous bytes. Together, these checks reject exactly the byte sequences rejected by utf8::decoder.
+
+namespace utf8::detail::lookup {
+
+// Error bits. Some of them share a value, because they can never be set by the same first byte.
+constexpr inline uint8_t too_short = 1U << 0U; // 11______ 0_______ or 11______ 11______
+constexpr inline uint8_t too_long = 1U << 1U; // 0_______ 10______
+constexpr inline uint8_t overlong_3 = 1U << 2U; // 11100000 100_____
+constexpr inline uint8_t too_large = 1U << 3U; // 11110100 1001____, 11110100 101_____ or 11110101+ 1001____+
+constexpr inline uint8_t surrogate = 1U << 4U; // 11101101 101_____
+constexpr inline uint8_t overlong_2 = 1U << 5U; // 1100000_ 10______
+constexpr inline uint8_t too_large_1000 = 1U << 6U; // 11110101+ 1000____
+constexpr inline uint8_t overlong_4 = 1U << 6U; // 11110000 1000____
+constexpr inline uint8_t two_conts = 1U << 7U; // 10______ 10______
+constexpr inline uint8_t carry = too_short | too_long | two_conts;
+
+constexpr inline std::array<uint8_t, 16> byte_1_high{
+    too_long, // 0000____
+    too_long, // 0001____
+    too_long, // 0010____
+    too_long, // 0011____
+    too_long, // 0100____
+    too_long, // 0101____
+    too_long, // 0110____
+    too_long, // 0111____
+    two_conts, // 1000____
+    two_conts, // 1001____
+    two_conts, // 1010____
+    two_conts, // 1011____
+    too_short | overlong_2, // 1100____
+    too_short, // 1101____
+    too_short | overlong_3 | surrogate, // 1110____
+    too_short | too_large | too_large_1000 | overlong_4, // 1111____
+};
+
+constexpr inline std::array<uint8_t, 16> byte_1_low{
+    carry | overlong_3 | overlong_2 | overlong_4, // ____0000
+    carry | overlong_2, // ____0001
+    carry, // ____0010
+    carry, // ____0011
+    carry | too_large, // ____0100
+    carry | too_large | too_large_1000, // ____0101
+    carry | too_large | too_large_1000, // ____0110
+    carry | too_large | too_large_1000, // ____0111
+    carry | too_large | too_large_1000, // ____1000
+    carry | too_large | too_large_1000, // ____1001
+    carry | too_large | too_large_1000, // ____1010
+    carry | too_large | too_large_1000, // ____1011
+    carry | too_large | too_large_1000, // ____1100
+    carry | too_large | too_large_1000 | surrogate, // ____1101
+    carry | too_large | too_large_1000, // ____1110
+    carry | too_large | too_large_1000, // ____1111
+};
+
+constexpr inline std::array<uint8_t, 16> byte_2_high{
+    too_short, // 0000____
+    too_short, // 0001____
+    too_short, // 0010____
+    too_short, // 0011____
+    too_short, // 0100____
+    too_short, // 0101____
+    too_short, // 0110____
+    too_short, // 0111____
+    too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4, // 1000____
+    too_long | overlong_2 | two_conts | overlong_3 | too_large, // 1001____
+    too_long | overlong_2 | two_conts | surrogate | too_large, // 1010____
+    too_long | overlong_2 | two_conts | surrogate | too_large, // 1011____
+    too_short, // 1100____
+    too_short, // 1101____
+    too_short, // 1110____
+    too_short, // 1111____
+};
+
+// Subtracting (with saturation) these values from the two bytes preceding a byte leaves their high bit set if and only
+// if that byte must be a continuation byte of a three or four-byte character.
+constexpr inline uint8_t third_byte_threshold = 0xe0 - 0x80;
+constexpr inline uint8_t fourth_byte_threshold = 0xf0 - 0x80;
+
+// Subtracting (with saturation) these values from the last three bytes of a block leaves a non-zero value if and only
+// if that byte starts a character which does not end within the block.
+constexpr inline uint8_t max_last_byte = 0xc0 - 1;
+constexpr inline uint8_t max_second_last_byte = 0xe0 - 1;
+constexpr inline uint8_t max_third_last_byte = 0xf0 - 1;
+
+// Left-packing ("compression") tables: for every mask of lanes to keep, the indices of those lanes, first to last, in
+// the first positions. The following ones are for eight 32-bit lanes, with one index per lane.
+constexpr inline auto compress_8x32 = [] {
+	std::array<std::array<uint8_t, 8>, 0x100> table{};
+
+	for (std::size_t mask = 0; mask < table.size(); ++mask) {
+		uint8_t count{};
+		for (uint8_t lane = 0; lane < 8; ++lane) {
+			if ((mask & (1U << lane)) != 0) {
+				table.at(mask).at(count++) = lane;
+			}
+		}
+	}
+
+	return table;
+}();
+
+// The same for four 32-bit lanes, with byte indices, suitable for byte shuffles. Unused bytes are zeroed.
+constexpr inline auto compress_4x32 = [] {
+	constexpr uint8_t zero = 0x80;
+	std::array<std::array<uint8_t, 16>, 0x10> table{};
+
+	for (std::size_t mask = 0; mask < table.size(); ++mask) {
+		table.at(mask).fill(zero);
+		uint8_t count{};
+		for (uint8_t lane = 0; lane < 4; ++lane) {
+			if ((mask & (1U << lane)) != 0) {
+				for (uint8_t byte = 0; byte < 4; ++byte) {
+					table.at(mask).at(count * 4 + byte) = lane * 4 + byte;
+				}
+				++count;
+			}
+		}
+	}
+
+	return table;
+}();
+
+// Encoding tables, for four 32-bit lanes, each holding the UTF-8 encoding of a code point, first byte lowest. Every
+// index packs the lengths of the encodings, minus one, two bits per lane, and the entry gathers their bytes, first to
+// last, in the first positions. Unused bytes are zeroed.
+constexpr inline auto encode_4x32 = [] {
+	constexpr uint8_t zero = 0x80;
+	std::array<std::array<uint8_t, 16>, 0x100> table{};
+
+	for (std::size_t lengths = 0; lengths < table.size(); ++lengths) {
+		table.at(lengths).fill(zero);
+		uint8_t count{};
+		for (uint8_t lane = 0; lane < 4; ++lane) {
+			const auto length = ((lengths >> (2U * lane)) & 3U) + 1;
+			for (uint8_t byte = 0; byte < length; ++byte) {
+				table.at(lengths).at(count++) = lane * 4 + byte;
+			}
+		}
+	}
+
+	return table;
+}();
+
+// The same for eight 16-bit lanes, each holding the UTF-8 encoding of a code point below U+0800, indexed by the mask of
+// the lanes which hold a single byte.
+constexpr inline auto encode_8x16 = [] {
+	constexpr uint8_t zero = 0x80;
+	std::array<std::array<uint8_t, 16>, 0x100> table{};
+
+	for (std::size_t single = 0; single < table.size(); ++single) {
+		table.at(single).fill(zero);
+		uint8_t count{};
+		for (uint8_t lane = 0; lane < 8; ++lane) {
+			table.at(single).at(count++) = lane * 2;
+			if ((single & (1U << lane)) == 0) {
+				table.at(single).at(count++) = lane * 2 + 1;
+			}
+		}
+	}
+
+	return table;
+}();
+
+// Spreading of four lane bits, one bit out of two, so that masks of lanes add up to the indices of the table above.
+constexpr inline auto spread_4x2 = [] {
+	std::array<uint8_t, 0x10> table{};
+
+	for (std::size_t mask = 0; mask < table.size(); ++mask) {
+		for (uint8_t lane = 0; lane < 4; ++lane) {
+			if ((mask & (1U << lane)) != 0) {
+				table.at(mask) |= static_cast<uint8_t>(1U << (2U * lane));
+			}
+		}
+	}
+
+	return table;
+}();
+
+} // namespace utf8::detail::lookup
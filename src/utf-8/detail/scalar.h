@@ -0,0 +1,318 @@
+#pragma once
+
+#include "utf-8/validator.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+// Portable kernels, used at compile time and on targets without SIMD.
+
+namespace utf8::detail {
+
+/// @brief Result of a transcoding kernel
+struct transcode_result {
+	std::size_t consumed{}; ///< Number of input units consumed
+	std::size_t produced{}; ///< Number of output units produced
+};
+
+/// @brief Granularity of the vectorized transcoding kernels, in bytes
+///
+/// These kernels validate and transcode windows of that size, and stop at the first window which is not valid.
+constexpr inline std::size_t kernel_window = 64;
+
+/// @brief Encode a code point into UTF-16
+///
+/// @param code The code point, replaced by U+FFFD if it is a surrogate or beyond U+10FFFF
+/// @param out The output, with room for two code units
+///
+/// @return The number of code units written
+constexpr auto encode_utf16(unsigned long code, char16_t *out) -> std::size_t
+{
+	static constexpr unsigned long first_supplementary = 0x10000;
+	static constexpr unsigned long last_code_point = 0x10ffff;
+	static constexpr unsigned long surrogate_mask = 0x3ff;
+	static constexpr auto surrogate_shift = 10;
+
+	if (code >= first_supplementary and code <= last_code_point) {
+		const auto offset = code - first_supplementary;
+		out[0] = static_cast<char16_t>(0xd800 + (offset >> surrogate_shift));
+		out[1] = static_cast<char16_t>(0xdc00 + (offset & surrogate_mask));
+		return 2;
+	}
+
+	out[0] = static_cast<char16_t>(code >= 0xd800 and (code <= 0xdfff or code > last_code_point) ? 0xfffd : code);
+	return 1;
+}
+
+/// @brief Check whether a UTF-16 code unit is a high surrogate, i.e. the first of a surrogate pair
+constexpr auto is_high_surrogate(char16_t unit) -> bool
+{
+	return (unit & 0xfc00) == 0xd800;
+}
+
+/// @brief Check whether two UTF-16 code units form a surrogate pair
+constexpr auto is_surrogate_pair(char16_t first, char16_t second) -> bool
+{
+	return is_high_surrogate(first) and (second & 0xfc00) == 0xdc00;
+}
+
+/// @brief Decode a surrogate pair, see utf8::detail::is_surrogate_pair
+constexpr auto decode_surrogate_pair(char16_t first, char16_t second) -> unsigned long
+{
+	static constexpr auto surrogate_shift = 10;
+
+	return 0x10000 + ((static_cast<unsigned long>(first) - 0xd800) << surrogate_shift) +
+	       (static_cast<unsigned long>(second) - 0xdc00);
+}
+
+/// @brief Calculate the length of the UTF-8 encoding of a code point
+///
+/// @param code The code point, replaced by U+FFFD if it is a surrogate or beyond U+10FFFF
+///
+/// @return The number of bytes utf8::detail::encode_utf8 writes
+constexpr auto utf8_length(unsigned long code) -> std::size_t
+{
+	if (code < 0x80) {
+		return 1;
+	}
+	if (code < 0x800) {
+		return 2;
+	}
+	// Surrogates are encoded on three bytes anyway, and values beyond U+10FFFF are replaced by U+FFFD.
+	return code >= 0x10000 and code <= 0x10ffff ? 4 : 3;
+}
+
+/// @brief Encode a code point into UTF-8
+///
+/// @param code The code point, replaced by U+FFFD if it is a surrogate or beyond U+10FFFF
+/// @param out The output, with room for four bytes
+///
+/// @return The number of bytes written
+constexpr auto encode_utf8(unsigned long code, char8_t *out) -> std::size_t
+{
+	static constexpr unsigned long last_code_point = 0x10ffff;
+	static constexpr unsigned long data_mask = 0x3f;
+	static constexpr auto data_shift = 6;
+
+	const auto continuation = [&](int shift) {
+		return static_cast<char8_t>(0x80 | ((code >> (shift * data_shift)) & data_mask));
+	};
+
+	if (code < 0x80) {
+		out[0] = static_cast<char8_t>(code);
+		return 1;
+	}
+	if (code < 0x800) {
+		out[0] = static_cast<char8_t>(0xc0 | (code >> data_shift));
+		out[1] = continuation(0);
+		return 2;
+	}
+	if (code >= 0xd800 and (code <= 0xdfff or code > last_code_point)) {
+		code = 0xfffd;
+	}
+	if (code < 0x10000) {
+		out[0] = static_cast<char8_t>(0xe0 | (code >> (2 * data_shift)));
+		out[1] = continuation(1);
+		out[2] = continuation(0);
+		return 3;
+	}
+	out[0] = static_cast<char8_t>(0xf0 | (code >> (3 * data_shift)));
+	out[1] = continuation(2);
+	out[2] = continuation(1);
+	out[3] = continuation(0);
+	return 4;
+}
+
+} // namespace utf8::detail
+
+namespace utf8::detail::scalar {
+
+/// @brief Count the ASCII bytes at the beginning of a sequence, testing 8 bytes at a time
+///
+/// @param bytes The sequence
+///
+/// @return The number of leading ASCII bytes
+constexpr auto ascii_prefix(std::span<const char8_t> bytes) -> std::size_t
+{
+	std::size_t count{};
+
+	if !consteval {
+		static constexpr uint64_t high_bits = 0x8080808080808080;
+		static constexpr auto byte_width = 8;
+
+		for (; count + sizeof(uint64_t) <= bytes.size(); count += sizeof(uint64_t)) {
+			uint64_t word{};
+			std::memcpy(&word, bytes.data() + count, sizeof(word));
+			if (const auto non_ascii = word & high_bits; non_ascii != 0) {
+				const auto bits = std::endian::native == std::endian::little
+						      ? std::countr_zero(non_ascii)
+						      : std::countl_zero(non_ascii);
+				return count + static_cast<std::size_t>(bits / byte_width);
+			}
+		}
+	}
+
+	while (count < bytes.size() and bytes[count] < 0x80) {
+		++count;
+	}
+
+	return count;
+}
+
+/// @brief Find the end of the last complete character of a window, assuming valid UTF-8
+///
+/// @param window The window, starting at a character boundary
+///
+/// @return The size of the window, excluding any character starting in it but not ending in it
+constexpr auto complete_prefix(std::span<const char8_t> window) -> std::size_t
+{
+	constexpr auto max_continuation_bytes = 3U;
+
+	for (auto i = window.size(); i > 0 and window.size() - i < max_continuation_bytes;) {
+		const auto byte = window[--i];
+		if (byte < 0x80) {
+			break;
+		}
+		if (byte >= 0xc0) {
+			const std::size_t length = byte >= 0xf0 ? 4 : byte >= 0xe0 ? 3 : 2;
+			return i + length <= window.size() ? window.size() : i;
+		}
+	}
+
+	return window.size();
+}
+
+constexpr auto validate(std::span<const char8_t> bytes) -> bool
+{
+	utf8::validator validator{};
+
+	for (const auto byte : bytes) {
+		if (not validator.validate(byte)) {
+			return false;
+		}
+	}
+
+	return not validator.check_last_error();
+}
+
+/// @brief Transcode the longest valid UTF-8 prefix the kernel can handle into UTF-32
+///
+/// @param bytes The UTF-8 sequence, starting at a character boundary
+/// @param out The output, with room for at least as many code points as there are bytes
+///
+/// @return The number of bytes consumed, always at a character boundary, and of code points produced
+///
+/// @note This kernel only handles ASCII.
+constexpr auto to_utf32(std::span<const char8_t> bytes, char32_t *out) -> transcode_result
+{
+	const auto run = ascii_prefix(bytes);
+
+	for (std::size_t i = 0; i < run; ++i) {
+		out[i] = bytes[i];
+	}
+
+	return {run, run};
+}
+
+/// @brief Count the code points of the longest valid UTF-8 prefix the kernel can handle
+///
+/// @param bytes The UTF-8 sequence, starting at a character boundary
+///
+/// @return The number of bytes consumed, always at a character boundary, and of code points counted
+///
+/// @note This kernel only handles ASCII.
+constexpr auto count_code_points(std::span<const char8_t> bytes) -> transcode_result
+{
+	const auto run = ascii_prefix(bytes);
+
+	return {run, run};
+}
+
+/// @brief Transcode the longest valid UTF-8 prefix the kernel can handle into UTF-16
+///
+/// @param bytes The UTF-8 sequence, starting at a character boundary
+/// @param out The output, with room for at least as many code units as there are bytes
+///
+/// @return The number of bytes consumed, always at a character boundary, and of code units produced
+///
+/// @note This kernel only handles ASCII.
+constexpr auto to_utf16(std::span<const char8_t> bytes, char16_t *out) -> transcode_result
+{
+	const auto run = ascii_prefix(bytes);
+
+	for (std::size_t i = 0; i < run; ++i) {
+		out[i] = bytes[i];
+	}
+
+	return {run, run};
+}
+
+/// @brief Encode code points into UTF-8
+///
+/// @param code_points The code points
+/// @param out The output
+///
+/// @return The number of code points consumed and of bytes produced, up to the first code point which does not fit
+constexpr auto from_utf32(std::span<const char32_t> code_points, std::span<char8_t> out) -> transcode_result
+{
+	transcode_result result{};
+
+	for (; result.consumed < code_points.size(); ++result.consumed) {
+		const auto code = code_points[result.consumed];
+		if (utf8_length(code) > out.size() - result.produced) {
+			break;
+		}
+		result.produced += encode_utf8(code, out.data() + result.produced);
+	}
+
+	return result;
+}
+
+/// @brief Transcode UTF-16 into UTF-8
+///
+/// @param code_units The UTF-16 sequence, of which unpaired surrogates are encoded as U+FFFD
+/// @param out The output
+///
+/// @return The number of code units consumed and of bytes produced, up to the first code point which does not fit
+///
+/// @note A high surrogate at the end of the sequence is unpaired.
+constexpr auto from_utf16(std::span<const char16_t> code_units, std::span<char8_t> out) -> transcode_result
+{
+	transcode_result result{};
+
+	while (result.consumed < code_units.size()) {
+		const auto first = code_units[result.consumed];
+		const auto pair = result.consumed + 1 < code_units.size() and
+				  is_surrogate_pair(first, code_units[result.consumed + 1]);
+		const auto code = pair ? decode_surrogate_pair(first, code_units[result.consumed + 1]) : first;
+
+		if (utf8_length(code) > out.size() - result.produced) {
+			break;
+		}
+		result.produced += encode_utf8(code, out.data() + result.produced);
+		result.consumed += pair ? 2 : 1;
+	}
+
+	return result;
+}
+
+/// @brief Calculate the length of code points in UTF-8
+///
+/// @param code_points The code points
+///
+/// @return The number of bytes utf8::detail::scalar::from_utf32 produces for the code points
+constexpr auto encoded_length(std::span<const char32_t> code_points) -> std::size_t
+{
+	std::size_t length{};
+
+	for (const auto code : code_points) {
+		length += utf8_length(code);
+	}
+
+	return length;
+}
+
+} // namespace utf8::detail::scalar
@@ -0,0 +1,510 @@
+#pragma once
+
+#include "utf-8/detail/cpu.h"
+
+#if defined(UTF_8_DETAIL_X86)
+
+#include "utf-8/detail/lookup.h"
+#include "utf-8/detail/scalar.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <span>
+
+#include <nmmintrin.h>
+
+// SSE4.2 kernels, processing 16 bytes at a time.
+
+namespace utf8::detail::sse42 {
+
+UTF_8_DETAIL_TARGET("sse4.2") inline auto load_table(const std::array<uint8_t, 16> &table) -> __m128i
+{
+	return _mm_loadu_si128(reinterpret_cast<const __m128i *>(table.data()));
+}
+
+/// @brief Look for errors in a block
+///
+/// @param input The block
+/// @param prev_input The previous block, or zeros at the beginning of the sequence
+///
+/// @return Non-zero bytes at the positions of errors
+UTF_8_DETAIL_TARGET("sse4.2") inline auto check_block(__m128i input, __m128i prev_input) -> __m128i
+{
+	const auto nibble_mask = _mm_set1_epi8(0x0f);
+
+	const auto prev1 = _mm_alignr_epi8(input, prev_input, 16 - 1);
+	const auto byte_1_high = _mm_shuffle_epi8(load_table(lookup::byte_1_high),
+						  _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble_mask));
+	const auto byte_1_low = _mm_shuffle_epi8(load_table(lookup::byte_1_low), _mm_and_si128(prev1, nibble_mask));
+	const auto byte_2_high = _mm_shuffle_epi8(load_table(lookup::byte_2_high),
+						  _mm_and_si128(_mm_srli_epi16(input, 4), nibble_mask));
+	const auto special_cases = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+	const auto prev2 = _mm_alignr_epi8(input, prev_input, 16 - 2);
+	const auto prev3 = _mm_alignr_epi8(input, prev_input, 16 - 3);
+	const auto must_be_continuation =
+	    _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(lookup::third_byte_threshold)),
+			 _mm_subs_epu8(prev3, _mm_set1_epi8(lookup::fourth_byte_threshold)));
+
+	return _mm_xor_si128(_mm_and_si128(must_be_continuation, _mm_set1_epi8(static_cast<char>(0x80))),
+			     special_cases);
+}
+
+/// @brief Check whether a block ends in the middle of a character
+///
+/// @param input The block
+///
+/// @return Non-zero bytes at the positions of start bytes whose character does not end within the block
+UTF_8_DETAIL_TARGET("sse4.2") inline auto is_incomplete(__m128i input) -> __m128i
+{
+	static constexpr auto any = static_cast<char>(0xff);
+	return _mm_subs_epu8(input, _mm_setr_epi8(any, any, any, any, any, any, any, any, any, any, any, any, any,
+						  static_cast<char>(lookup::max_third_last_byte),
+						  static_cast<char>(lookup::max_second_last_byte),
+						  static_cast<char>(lookup::max_last_byte)));
+}
+
+/// @brief Load a block which may extend beyond the end of the sequence
+///
+/// @param data The beginning of the block
+/// @param size The number of bytes left in the sequence
+///
+/// @return The block, padded with zeros if needed
+UTF_8_DETAIL_TARGET("sse4.2") inline auto load_block(const char8_t *data, std::size_t size) -> __m128i
+{
+	if (size >= sizeof(__m128i)) {
+		return _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+	}
+
+	std::array<char8_t, sizeof(__m128i)> block{};
+	std::memcpy(block.data(), data, size);
+	return _mm_loadu_si128(reinterpret_cast<const __m128i *>(block.data()));
+}
+
+UTF_8_DETAIL_TARGET("sse4.2") inline auto validate(std::span<const char8_t> bytes) -> bool
+{
+	auto error = _mm_setzero_si128();
+	auto prev_input = _mm_setzero_si128();
+	auto prev_incomplete = _mm_setzero_si128();
+
+	// Zero padding is ASCII, so it terminates the sequence like its actual end would.
+	for (std::size_t offset = 0; offset < bytes.size(); offset += sizeof(__m128i)) {
+		const auto input = load_block(bytes.data() + offset, bytes.size() - offset);
+
+		if (_mm_movemask_epi8(input) == 0) {
+			error = _mm_or_si128(error, prev_incomplete);
+			prev_incomplete = _mm_setzero_si128();
+		} else {
+			error = _mm_or_si128(error, check_block(input, prev_input));
+			prev_incomplete = is_incomplete(input);
+		}
+		prev_input = input;
+	}
+
+	error = _mm_or_si128(error, prev_incomplete);
+
+	return _mm_testz_si128(error, error) != 0;
+}
+
+/// @brief Decode the characters starting at four consecutive positions, assuming valid UTF-8
+///
+/// @param window The bytes from the first position, of which the first seven are used
+///
+/// @return The code points, in 32-bit lanes, meaningless for positions of continuation bytes
+UTF_8_DETAIL_TARGET("sse4.2") inline auto decode_lanes(__m128i window) -> __m128i
+{
+	// Every lane gets the four bytes starting at its position, first byte lowest.
+	const auto lanes = _mm_shuffle_epi8(window, _mm_setr_epi8(0, 1, 2, 3, 1, 2, 3, 4, 2, 3, 4, 5, 3, 4, 5, 6));
+
+	const auto data_mask = _mm_set1_epi32(0x3f);
+	const auto byte0 = _mm_and_si128(lanes, _mm_set1_epi32(0xff));
+	const auto data1 = _mm_and_si128(_mm_srli_epi32(lanes, 8), data_mask);
+	const auto data2 = _mm_and_si128(_mm_srli_epi32(lanes, 16), data_mask);
+	const auto data3 = _mm_and_si128(_mm_srli_epi32(lanes, 24), data_mask);
+
+	const auto two = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(byte0, _mm_set1_epi32(0x1f)), 6), data1);
+	const auto three = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(byte0, _mm_set1_epi32(0x0f)), 12),
+					 _mm_or_si128(_mm_slli_epi32(data1, 6), data2));
+	const auto four = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(byte0, _mm_set1_epi32(0x07)), 18),
+						    _mm_slli_epi32(data1, 12)),
+				       _mm_or_si128(_mm_slli_epi32(data2, 6), data3));
+
+	auto code_points = _mm_blendv_epi8(four, three, _mm_cmpgt_epi32(_mm_set1_epi32(0xf0), byte0));
+	code_points = _mm_blendv_epi8(code_points, two, _mm_cmpgt_epi32(_mm_set1_epi32(0xe0), byte0));
+	return _mm_blendv_epi8(code_points, byte0, _mm_cmpgt_epi32(_mm_set1_epi32(0x80), byte0));
+}
+
+/// @brief Transcode valid UTF-8 into UTF-32
+///
+/// @param data The UTF-8 sequence, starting at a character boundary, readable 16 bytes beyond its end
+/// @param size The size of the sequence, ending at a character boundary
+/// @param out The output, writable 4 code points beyond the last produced one
+///
+/// @return The number of code points produced
+UTF_8_DETAIL_TARGET("sse4.2") inline auto transcode_valid(const char8_t *data, std::size_t size, char32_t *out)
+    -> std::size_t
+{
+	static constexpr auto step = 4U;
+	static constexpr auto all_lanes = (1U << step) - 1;
+	static constexpr auto min_start_byte = static_cast<char>(0xc0 - 1);
+
+	std::size_t produced{};
+
+	for (std::size_t offset = 0; offset < size; offset += step) {
+		const auto window = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + offset));
+		const auto code_points = decode_lanes(window);
+
+		// Only lanes of ASCII and start bytes, in the sequence, hold a code point.
+		const auto is_first_byte = _mm_cmpgt_epi8(window, _mm_set1_epi8(min_start_byte));
+		const auto in_sequence = size - offset >= step ? all_lanes : (1U << (size - offset)) - 1;
+		const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(is_first_byte)) & in_sequence;
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + produced),
+				 _mm_shuffle_epi8(code_points, load_table(lookup::compress_4x32.at(mask))));
+		produced += static_cast<std::size_t>(std::popcount(mask));
+	}
+
+	return produced;
+}
+
+/// @brief Check whether a transcoding window is ASCII
+UTF_8_DETAIL_TARGET("sse4.2") inline auto is_ascii_window(const char8_t *data) -> bool
+{
+	auto any = _mm_setzero_si128();
+	for (std::size_t offset = 0; offset < kernel_window; offset += sizeof(__m128i)) {
+		any = _mm_or_si128(any, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + offset)));
+	}
+
+	return _mm_movemask_epi8(any) == 0;
+}
+
+/// @brief Check whether a transcoding window, starting at a character boundary, is valid
+///
+/// @note Any character starting in the window, but not ending in it, is not checked, but left for the next window.
+UTF_8_DETAIL_TARGET("sse4.2") inline auto is_valid_window(const char8_t *data) -> bool
+{
+	auto error = _mm_setzero_si128();
+	auto prev_input = _mm_setzero_si128();
+	for (std::size_t offset = 0; offset < kernel_window; offset += sizeof(__m128i)) {
+		const auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + offset));
+		error = _mm_or_si128(error, check_block(input, prev_input));
+		prev_input = input;
+	}
+
+	return _mm_testz_si128(error, error) != 0;
+}
+
+/// @brief Encode code points into UTF-16
+///
+/// @param code_points The code points, readable 8 code points beyond the last one
+/// @param count The number of code points
+/// @param out The output, writable 8 code units beyond the last produced one
+///
+/// @return The number of code units produced
+UTF_8_DETAIL_TARGET("sse4.2") inline auto narrow_to_utf16(const char32_t *code_points, std::size_t count, char16_t *out)
+    -> std::size_t
+{
+	static constexpr std::size_t step = 8;
+
+	std::size_t produced{};
+
+	for (std::size_t i = 0; i < count; i += step) {
+		const auto low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(code_points + i));
+		const auto high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(code_points + i + step / 2));
+		const auto last_bmp = _mm_set1_epi32(0xffff);
+		const auto supplementary =
+		    _mm_or_si128(_mm_cmpgt_epi32(low, last_bmp), _mm_cmpgt_epi32(high, last_bmp));
+		const auto size = std::min(step, count - i);
+
+		// Surrogate pairs are rare enough for their group of code points to be encoded one at a time.
+		if (_mm_testz_si128(supplementary, supplementary) != 0) {
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + produced), _mm_packus_epi32(low, high));
+			produced += size;
+		} else {
+			for (std::size_t j = 0; j < size; ++j) {
+				produced += encode_utf16(code_points[i + j], out + produced);
+			}
+		}
+	}
+
+	return produced;
+}
+
+UTF_8_DETAIL_TARGET("sse4.2") inline auto to_utf32(std::span<const char8_t> bytes, char32_t *out) -> transcode_result
+{
+	static constexpr auto lookahead = sizeof(__m128i);
+
+	transcode_result result{};
+
+	while (bytes.size() - result.consumed >= kernel_window + lookahead) {
+		const auto *data = bytes.data() + result.consumed;
+
+		if (is_ascii_window(data)) {
+			for (std::size_t offset = 0; offset < kernel_window; offset += sizeof(uint32_t)) {
+				uint32_t word{};
+				std::memcpy(&word, data + offset, sizeof(word));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(out + result.produced + offset),
+						 _mm_cvtepu8_epi32(_mm_cvtsi32_si128(static_cast<int>(word))));
+			}
+			result.consumed += kernel_window;
+			result.produced += kernel_window;
+			continue;
+		}
+
+		if (not is_valid_window(data)) {
+			break;
+		}
+
+		const auto size = scalar::complete_prefix({data, kernel_window});
+		result.produced += transcode_valid(data, size, out + result.produced);
+		result.consumed += size;
+	}
+
+	// The rest of the sequence, or the window in error, may still begin with ASCII.
+	const auto ascii = scalar::to_utf32(bytes.subspan(result.consumed), out + result.produced);
+	result.consumed += ascii.consumed;
+	result.produced += ascii.produced;
+
+	return result;
+}
+
+UTF_8_DETAIL_TARGET("sse4.2") inline auto to_utf16(std::span<const char8_t> bytes, char16_t *out) -> transcode_result
+{
+	static constexpr auto lookahead = sizeof(__m128i);
+
+	transcode_result result{};
+	// Encoding into UTF-16 reads whole steps of code points.
+	std::array<char32_t, kernel_window + sizeof(__m128i) / 2> code_points{};
+
+	while (bytes.size() - result.consumed >= kernel_window + lookahead) {
+		const auto *data = bytes.data() + result.consumed;
+
+		if (is_ascii_window(data)) {
+			for (std::size_t offset = 0; offset < kernel_window; offset += sizeof(uint64_t)) {
+				const auto bytes_8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(data + offset));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(out + result.produced + offset),
+						 _mm_cvtepu8_epi16(bytes_8));
+			}
+			result.consumed += kernel_window;
+			result.produced += kernel_window;
+			continue;
+		}
+
+		if (not is_valid_window(data)) {
+			break;
+		}
+
+		const auto size = scalar::complete_prefix({data, kernel_window});
+		const auto count = transcode_valid(data, size, code_points.data());
+		result.produced += narrow_to_utf16(code_points.data(), count, out + result.produced);
+		result.consumed += size;
+	}
+
+	const auto ascii = scalar::to_utf16(bytes.subspan(result.consumed), out + result.produced);
+	result.consumed += ascii.consumed;
+	result.produced += ascii.produced;
+
+	return result;
+}
+
+UTF_8_DETAIL_TARGET("sse4.2") inline auto count_code_points(std::span<const char8_t> bytes) -> transcode_result
+{
+	static constexpr auto max_continuation_byte = static_cast<char>(0xbf);
+
+	transcode_result result{};
+
+	while (bytes.size() - result.consumed >= kernel_window) {
+		const auto *data = bytes.data() + result.consumed;
+
+		if (is_ascii_window(data)) {
+			result.consumed += kernel_window;
+			result.produced += kernel_window;
+			continue;
+		}
+
+		if (not is_valid_window(data)) {
+			break;
+		}
+
+		// Every byte but the continuation bytes starts a code point, including the one of an incomplete
+		// character at the end of the window, which is left for the next window.
+		std::size_t count{};
+		for (std::size_t offset = 0; offset < kernel_window; offset += sizeof(__m128i)) {
+			const auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + offset));
+			const auto is_first_byte = _mm_cmpgt_epi8(input, _mm_set1_epi8(max_continuation_byte));
+			const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(is_first_byte));
+			count += static_cast<std::size_t>(std::popcount(mask));
+		}
+		const auto size = scalar::complete_prefix({data, kernel_window});
+		result.consumed += size;
+		result.produced += count - (size != kernel_window ? 1 : 0);
+	}
+
+	const auto ascii = scalar::count_code_points(bytes.subspan(result.consumed));
+	result.consumed += ascii.consumed;
+	result.produced += ascii.produced;
+
+	return result;
+}
+
+/// @brief Replace the values which are not Unicode scalar values by U+FFFD
+UTF_8_DETAIL_TARGET("sse4.2") inline auto scalar_values(__m128i code_points) -> __m128i
+{
+	// Beyond U+10FFFF, values are saturated first, since comparisons are signed.
+	const auto beyond = _mm_set1_epi32(0x110000);
+	const auto saturated = _mm_min_epu32(code_points, beyond);
+	const auto invalid =
+	    _mm_or_si128(_mm_cmpeq_epi32(saturated, beyond),
+			 _mm_cmpeq_epi32(_mm_and_si128(saturated, _mm_set1_epi32(~0x7ff)), _mm_set1_epi32(0xd800)));
+
+	return _mm_blendv_epi8(saturated, _mm_set1_epi32(0xfffd), invalid);
+}
+
+/// @brief Encode four code points into UTF-8
+///
+/// @param code_points The code points
+/// @param out The output, writable 16 bytes from the beginning
+///
+/// @return The number of bytes produced
+UTF_8_DETAIL_TARGET("sse4.2") inline auto encode_lanes(__m128i code_points, char8_t *out) -> std::size_t
+{
+	const auto code = scalar_values(code_points);
+
+	// Every lane gets the encodings of its code point on two, three and four bytes, first byte lowest.
+	const auto data_mask = _mm_set1_epi32(0x3f);
+	const auto continuation = _mm_set1_epi32(0x80);
+	const auto data0 = _mm_or_si128(_mm_and_si128(code, data_mask), continuation);
+	const auto data1 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(code, 6), data_mask), continuation);
+	const auto data2 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(code, 12), data_mask), continuation);
+
+	const auto two = _mm_or_si128(_mm_or_si128(_mm_srli_epi32(code, 6), _mm_set1_epi32(0xc0)),
+				      _mm_slli_epi32(data0, 8));
+	const auto three = _mm_or_si128(_mm_or_si128(_mm_srli_epi32(code, 12), _mm_set1_epi32(0xe0)),
+					_mm_or_si128(_mm_slli_epi32(data1, 8), _mm_slli_epi32(data0, 16)));
+	const auto four =
+	    _mm_or_si128(_mm_or_si128(_mm_srli_epi32(code, 18), _mm_set1_epi32(0xf0)),
+			 _mm_or_si128(_mm_slli_epi32(data2, 8),
+				      _mm_or_si128(_mm_slli_epi32(data1, 16), _mm_slli_epi32(data0, 24))));
+
+	const auto is_multi_byte = _mm_cmpgt_epi32(code, _mm_set1_epi32(0x7f));
+	const auto is_three_byte = _mm_cmpgt_epi32(code, _mm_set1_epi32(0x7ff));
+	const auto is_four_byte = _mm_cmpgt_epi32(code, _mm_set1_epi32(0xffff));
+
+	auto encoded = _mm_blendv_epi8(code, two, is_multi_byte);
+	encoded = _mm_blendv_epi8(encoded, three, is_three_byte);
+	encoded = _mm_blendv_epi8(encoded, four, is_four_byte);
+
+	// Every mask adds one byte to the length of its lanes.
+	const auto multi_byte = static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(is_multi_byte)));
+	const auto three_byte = static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(is_three_byte)));
+	const auto four_byte = static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(is_four_byte)));
+	const auto lengths = lookup::spread_4x2.at(multi_byte) + lookup::spread_4x2.at(three_byte) +
+			     lookup::spread_4x2.at(four_byte);
+
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+			 _mm_shuffle_epi8(encoded, load_table(lookup::encode_4x32.at(lengths))));
+
+	return 4 + static_cast<std::size_t>(std::popcount(multi_byte) + std::popcount(three_byte) +
+					    std::popcount(four_byte));
+}
+
+/// @brief Encode eight code points below U+0800 into UTF-8
+///
+/// @param code_points The code points, in 16-bit lanes
+/// @param out The output, writable 16 bytes from the beginning
+///
+/// @return The number of bytes produced
+UTF_8_DETAIL_TARGET("sse4.2") inline auto encode_two_byte_lanes(__m128i code_points, char8_t *out) -> std::size_t
+{
+	static constexpr auto lanes = 8U;
+
+	const auto is_ascii = _mm_cmplt_epi16(code_points, _mm_set1_epi16(0x80));
+	const auto first = _mm_or_si128(_mm_srli_epi16(code_points, 6), _mm_set1_epi16(0xc0));
+	const auto second = _mm_or_si128(_mm_and_si128(code_points, _mm_set1_epi16(0x3f)), _mm_set1_epi16(0x80));
+	const auto encoded = _mm_blendv_epi8(_mm_or_si128(first, _mm_slli_epi16(second, 8)), code_points, is_ascii);
+
+	const auto single = static_cast<unsigned int>(_mm_movemask_epi8(_mm_packs_epi16(is_ascii, is_ascii))) & 0xffU;
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+			 _mm_shuffle_epi8(encoded, load_table(lookup::encode_8x16.at(single))));
+
+	return 2 * lanes - static_cast<std::size_t>(std::popcount(single));
+}
+
+UTF_8_DETAIL_TARGET("sse4.2") inline auto from_utf32(std::span<const char32_t> code_points, std::span<char8_t> out)
+    -> transcode_result
+{
+	static constexpr std::size_t step = sizeof(__m128i) / sizeof(char32_t);
+	static constexpr std::size_t block = 4 * step;
+	// A block produces at most four bytes per code point, and every store writes a whole vector within them.
+	static constexpr std::size_t max_block_bytes = 4 * block;
+
+	transcode_result result{};
+
+	while (code_points.size() - result.consumed >= block and out.size() - result.produced >= max_block_bytes) {
+		const auto *data = reinterpret_cast<const __m128i *>(code_points.data() + result.consumed);
+		const auto first = _mm_loadu_si128(data);
+		const auto second = _mm_loadu_si128(data + 1);
+		const auto third = _mm_loadu_si128(data + 2);
+		const auto fourth = _mm_loadu_si128(data + 3);
+
+		const auto any = _mm_or_si128(_mm_or_si128(first, second), _mm_or_si128(third, fourth));
+		if (_mm_testz_si128(any, _mm_set1_epi32(~0x7f)) != 0) {
+			const auto packed =
+			    _mm_packus_epi16(_mm_packus_epi32(first, second), _mm_packus_epi32(third, fourth));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out.data() + result.produced), packed);
+			result.produced += block;
+		} else if (_mm_testz_si128(any, _mm_set1_epi32(~0x7ff)) != 0) {
+			// Below U+0800, code points fit in 16-bit lanes, twice as many at a time.
+			result.produced += encode_two_byte_lanes(_mm_packus_epi32(first, second),
+								 out.data() + result.produced);
+			result.produced += encode_two_byte_lanes(_mm_packus_epi32(third, fourth),
+								 out.data() + result.produced);
+		} else {
+			for (const auto code : {first, second, third, fourth}) {
+				result.produced += encode_lanes(code, out.data() + result.produced);
+			}
+		}
+		result.consumed += block;
+	}
+
+	const auto rest = scalar::from_utf32(code_points.subspan(result.consumed), out.subspan(result.produced));
+	result.consumed += rest.consumed;
+	result.produced += rest.produced;
+
+	return result;
+}
+
+UTF_8_DETAIL_TARGET("sse4.2") inline auto encoded_length(std::span<const char32_t> code_points) -> std::size_t
+{
+	static constexpr std::size_t step = sizeof(__m128i) / sizeof(char32_t);
+	// Lanes count at most three extra bytes per code point, and are summed before they could overflow.
+	static constexpr std::size_t chunk = std::size_t{1} << 24U;
+
+	std::size_t offset{};
+	std::size_t length{};
+
+	while (code_points.size() - offset >= step) {
+		const auto end = offset + std::min(chunk, (code_points.size() - offset) / step * step);
+		auto extra = _mm_setzero_si128();
+
+		for (; offset < end; offset += step) {
+			const auto code = scalar_values(
+			    _mm_loadu_si128(reinterpret_cast<const __m128i *>(code_points.data() + offset)));
+			extra = _mm_sub_epi32(extra, _mm_cmpgt_epi32(code, _mm_set1_epi32(0x7f)));
+			extra = _mm_sub_epi32(extra, _mm_cmpgt_epi32(code, _mm_set1_epi32(0x7ff)));
+			extra = _mm_sub_epi32(extra, _mm_cmpgt_epi32(code, _mm_set1_epi32(0xffff)));
+		}
+
+		extra = _mm_add_epi32(extra, _mm_shuffle_epi32(extra, 0x4e));
+		extra = _mm_add_epi32(extra, _mm_shuffle_epi32(extra, 0xb1));
+		length += static_cast<uint32_t>(_mm_cvtsi128_si32(extra));
+	}
+
+	return offset + length + scalar::encoded_length(code_points.subspan(offset));
+}
+
+} // namespace utf8::detail::sse42
+
+#endif
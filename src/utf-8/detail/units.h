@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+
+// A UTF-8 sequence decodes into a sequence of code points in which every code point comes from its own run of bytes,
+// either a character, or a maximal subpart or byte in error. Those runs, which we call units, partition the sequence:
+// every byte which is not a continuation byte starts a unit, and a unit spans at most four bytes. The following
+// functions delimit units, forward and backward, and always agree with utf8::decoder.
+
+namespace utf8::detail {
+
+constexpr inline unsigned long replacement_char = 0xfffd;
+constexpr inline std::size_t max_unit_length = 4;
+
+/// @brief Check whether a byte is a continuation byte
+constexpr auto is_continuation(char8_t byte) -> bool
+{
+	static constexpr auto continuation_mask = 0xc0;
+	static constexpr auto continuation_bits = 0x80;
+
+	return (byte & continuation_mask) == continuation_bits;
+}
+
+/// @brief Decode a unit
+///
+/// @param it The beginning of the unit, advanced to its end
+/// @param end The end of the sequence
+///
+/// @return The code point of the unit, U+FFFD if the unit is in error
+template <std::input_iterator I, std::sentinel_for<I> S>
+constexpr auto decode_unit(I &it, const S &end) -> unsigned long
+{
+	static constexpr auto data_mask = 0x3f;
+	static constexpr auto data_shift = 6;
+
+	const auto lead = static_cast<uint8_t>(*it);
+	++it;
+
+	if (lead < 0x80) {
+		return lead;
+	}
+	if (lead < 0xc2 or lead > 0xf4) {
+		return replacement_char;
+	}
+
+	// The lead byte restricts the range of the second byte, to exclude overlong encodings, surrogates and code
+	// points beyond U+10FFFF.
+	int length = 2;
+	unsigned long code = lead & 0x1fU;
+	uint8_t low = 0x80;
+	uint8_t high = 0xbf;
+
+	if (lead >= 0xf0) {
+		length = 4;
+		code = lead & 0x07U;
+		low = lead == 0xf0 ? 0x90 : low;
+		high = lead == 0xf4 ? 0x8f : high;
+	} else if (lead >= 0xe0) {
+		length = 3;
+		code = lead & 0x0fU;
+		low = lead == 0xe0 ? 0xa0 : low;
+		high = lead == 0xed ? 0x9f : high;
+	}
+
+	for (auto i = 1; i < length; ++i) {
+		if (it == end) {
+			return replacement_char;
+		}
+		const auto byte = static_cast<uint8_t>(*it);
+		if (byte < low or byte > high) {
+			return replacement_char;
+		}
+		code = (code << data_shift) | (byte & data_mask);
+		++it;
+		low = 0x80;
+		high = 0xbf;
+	}
+
+	return code;
+}
+
+/// @brief Decode the unit preceding a unit boundary
+///
+/// @param begin The beginning of the sequence
+/// @param it The unit boundary, after begin, moved to the beginning of the unit which ends there
+///
+/// @return The code point of the unit, U+FFFD if the unit is in error
+template <std::bidirectional_iterator I>
+constexpr auto decode_previous_unit(const I &begin, I &it) -> unsigned long
+{
+	const auto end = it;
+	const auto last = static_cast<char8_t>(*--it);
+
+	if (last < 0x80) {
+		return last;
+	}
+
+	// The unit starts at the closest byte which is not a continuation byte, if the unit of that byte extends up to
+	// the boundary. Otherwise, the last byte is a unit of its own.
+	auto start = it;
+	for (std::size_t distance = 1; is_continuation(static_cast<char8_t>(*start)); ++distance) {
+		if (distance == max_unit_length or start == begin) {
+			return replacement_char;
+		}
+		--start;
+	}
+
+	auto unit_end = start;
+	const auto code = decode_unit(unit_end, end);
+	if (unit_end != end) {
+		return replacement_char;
+	}
+
+	it = start;
+	return code;
+}
+
+/// @brief Check whether a position is a unit boundary
+///
+/// @param bytes The sequence
+/// @param pos The position, up to the size of the sequence
+///
+/// @return True if a unit starts or ends at the position
+///
+/// @note Since units span at most four bytes, only the byte at the position and the three preceding ones matter.
+constexpr auto is_unit_boundary(std::span<const char8_t> bytes, std::size_t pos) -> bool
+{
+	if (pos == 0 or pos == bytes.size() or not is_continuation(bytes[pos])) {
+		return true;
+	}
+
+	// A continuation byte is a unit of its own, unless the unit of the closest byte which is not a continuation
+	// byte extends over it.
+	auto start = pos;
+	do {
+		if (pos - start == max_unit_length - 1 or start == 0) {
+			return true;
+		}
+		--start;
+	} while (is_continuation(bytes[start]));
+
+	auto it = bytes.begin() + static_cast<std::ptrdiff_t>(start);
+	decode_unit(it, bytes.end());
+
+	return it <= bytes.begin() + static_cast<std::ptrdiff_t>(pos);
+}
+
+} // namespace utf8::detail
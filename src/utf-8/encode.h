@@ -0,0 +1,69 @@
+#pragma once
+
+#include "utf-8/detail/dispatch.h"
+#include "utf-8/detail/scalar.h"
+
+#include <cstddef>
+#include <span>
+
+namespace utf8 {
+
+/// @brief Calculate the length of a sequence of code points in UTF-8
+///
+/// @param code_points The code points
+///
+/// @return The exact number of bytes utf8::from_utf32 writes for the code points
+///
+/// @note At run time, code points are counted 4 or 8 at a time, with the most capable of SSE4.2 and AVX2 that the CPU
+/// supports.
+constexpr auto encoded_length(std::span<const char32_t> code_points) -> std::size_t
+{
+	if consteval {
+		return detail::scalar::encoded_length(code_points);
+	} else {
+		return detail::active_kernels().encoded_length(code_points);
+	}
+}
+
+/// @brief Encode a sequence of code points into UTF-8
+///
+/// @param code_points The code points
+/// @param bytes The output buffer, with room for as many bytes as utf8::encoded_length returns, or for four bytes per
+/// code point
+///
+/// @return The number of bytes written
+///
+/// @note Values which are not Unicode scalar values, i.e. surrogates and values beyond U+10FFFF, are encoded as
+/// U+FFFD, as with utf8::encoder. If the output is too short, encoding stops at the first code point which does not
+/// fit. At run time, code points are encoded 16 or 32 at a time, with the most capable of SSE4.2 and AVX2 that the CPU
+/// supports, and runs of ASCII are narrowed directly.
+constexpr auto from_utf32(std::span<const char32_t> code_points, std::span<char8_t> bytes) -> std::size_t
+{
+	if consteval {
+		return detail::scalar::from_utf32(code_points, bytes).produced;
+	} else {
+		return detail::active_kernels().from_utf32(code_points, bytes).produced;
+	}
+}
+
+/// @brief Transcode a UTF-16 sequence into UTF-8
+///
+/// @param code_units The UTF-16 sequence
+/// @param bytes The output buffer, with room for three bytes per code unit
+///
+/// @return The number of bytes written
+///
+/// @note Unpaired surrogates, including a high surrogate at the end of the sequence, are encoded as U+FFFD, exactly as
+/// with utf8::views::from_utf16. If the output is too short, transcoding stops at the first code point which does not
+/// fit. At run time, code units are transcoded 16 at a time with AVX2 if the CPU supports it, including surrogate
+/// pairs, and runs of ASCII are narrowed directly.
+constexpr auto from_utf16(std::span<const char16_t> code_units, std::span<char8_t> bytes) -> std::size_t
+{
+	if consteval {
+		return detail::scalar::from_utf16(code_units, bytes).produced;
+	} else {
+		return detail::active_kernels().from_utf16(code_units, bytes).produced;
+	}
+}
+
+} // namespace utf8
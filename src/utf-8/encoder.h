@@ -0,0 +1,38 @@
+#pragma once
+
+#include "utf-8/detail/scalar.h"
+
+#include <array>
+#include <cstddef>
+#include <span>
+
+namespace utf8 {
+
+/// @brief UTF-8 encoder, one code point at a time
+///
+/// The counterpart of utf8::decoder: every code point is encoded at once into all its bytes, which the encoder holds
+/// until the next code point. Values which are not Unicode scalar values, i.e. surrogates and values beyond U+10FFFF,
+/// are encoded as U+FFFD, which is also what utf8::decoder produces for their encodings.
+class encoder {
+	std::array<char8_t, 4> bytes_{};
+
+public:
+	/// @brief Calculate the length of the encoding of a code point
+	///
+	/// @param code The code point
+	///
+	/// @return The number of bytes utf8::encoder::encode produces for the code point
+	static constexpr auto length(unsigned long code) -> std::size_t { return detail::utf8_length(code); }
+
+	/// @brief Encode one code point
+	///
+	/// @param code The code point to encode
+	///
+	/// @return The bytes of the encoding, valid until the next invocation
+	constexpr auto encode(unsigned long code) -> std::span<const char8_t>
+	{
+		return {bytes_.data(), detail::encode_utf8(code, bytes_.data())};
+	}
+};
+
+} // namespace utf8
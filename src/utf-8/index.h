@@ -0,0 +1,157 @@
+#pragma once
+
+#include "utf-8/count.h"
+#include "utf-8/detail/units.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace utf8 {
+
+/// @brief Sparse index of the code points of a UTF-8 buffer
+///
+/// The index maps code point offsets to byte offsets and back, as utf8::decoder decodes the buffer, i.e. with a
+/// replacement character for every maximal subpart in error, located at the offset of that subpart. It holds
+/// checkpoints, couples of a byte offset and a code point offset, about every spacing bytes, hence at most every
+/// spacing code points. A query is a binary search among checkpoints, followed by the decoding of at most spacing + 3
+/// bytes. Memory overhead is two words per checkpoint, i.e. 16 / spacing bytes per byte on 64-bit targets.
+///
+/// The index does not own the buffer. Whenever the buffer is edited or moved, the index shall be updated with the new
+/// buffer before any query.
+class index {
+	struct checkpoint {
+		std::size_t byte{};
+		std::size_t code_point{};
+	};
+
+	std::span<const char8_t> bytes_;
+	std::size_t spacing_{};
+	std::vector<checkpoint> checkpoints_{{}}; // From the beginning of the buffer to its end
+
+	/// @brief Add the checkpoints following a checkpoint, up to a unit boundary
+	///
+	/// @param from The checkpoint
+	/// @param to The unit boundary, which gets the last checkpoint
+	/// @param out The checkpoints to add to
+	constexpr void add_checkpoints(checkpoint from, std::size_t to, std::vector<checkpoint> &out) const
+	{
+		while (from.byte < to) {
+			// Units span at most four bytes, so a unit boundary is never further.
+			auto next = std::min(to, from.byte + spacing_);
+			while (not detail::is_unit_boundary(bytes_, next)) {
+				++next;
+			}
+
+			from = {next, from.code_point + count_code_points(bytes_.subspan(from.byte, next - from.byte))};
+			out.push_back(from);
+		}
+	}
+
+	/// @brief Find the last checkpoint which satisfies a predicate, given that the first one does
+	constexpr auto last_checkpoint(auto predicate) const -> checkpoint
+	{
+		return *std::prev(std::ranges::partition_point(checkpoints_, predicate));
+	}
+
+public:
+	static constexpr std::size_t default_spacing = 1024;
+
+	/// @brief Build the index of a buffer
+	///
+	/// @param bytes The UTF-8 buffer
+	/// @param spacing The approximate number of bytes between checkpoints
+	constexpr explicit index(std::span<const char8_t> bytes, std::size_t spacing = default_spacing)
+	    : bytes_{bytes}, spacing_{std::max<std::size_t>(spacing, 1)}
+	{
+		checkpoints_.reserve(bytes.size() / spacing_ + 2);
+		add_checkpoints({}, bytes.size(), checkpoints_);
+	}
+
+	/// @brief Get the number of code points in the buffer
+	[[nodiscard]] constexpr auto size() const -> std::size_t { return checkpoints_.back().code_point; }
+
+	/// @brief Get the byte offset of a code point
+	///
+	/// @param code_point The code point offset, up to the number of code points in the buffer
+	///
+	/// @return The offset of the first byte the code point is decoded from, or the size of the buffer
+	[[nodiscard]] constexpr auto byte_offset(std::size_t code_point) const -> std::size_t
+	{
+		auto [byte, current] = last_checkpoint([=](checkpoint c) { return c.code_point <= code_point; });
+
+		auto it = bytes_.begin() + static_cast<std::ptrdiff_t>(byte);
+		for (; current < code_point; ++current) {
+			detail::decode_unit(it, bytes_.end());
+		}
+
+		return static_cast<std::size_t>(it - bytes_.begin());
+	}
+
+	/// @brief Get the code point offset of a byte
+	///
+	/// @param byte The byte offset, up to the size of the buffer
+	///
+	/// @return The offset of the code point decoded from the byte, or the number of code points in the buffer
+	[[nodiscard]] constexpr auto code_point_offset(std::size_t byte) const -> std::size_t
+	{
+		auto [start, current] = last_checkpoint([=](checkpoint c) { return c.byte <= byte; });
+
+		const auto target = bytes_.begin() + static_cast<std::ptrdiff_t>(byte);
+		for (auto it = bytes_.begin() + static_cast<std::ptrdiff_t>(start); it < target;) {
+			detail::decode_unit(it, bytes_.end());
+			if (it <= target) {
+				++current;
+			}
+		}
+
+		return current;
+	}
+
+	/// @brief Update the index after an edit of the buffer
+	///
+	/// @param bytes The edited buffer
+	/// @param offset The offset of the edit
+	/// @param removed The number of bytes removed at the offset
+	/// @param inserted The number of bytes inserted instead
+	///
+	/// @note Only the checkpoints around the edit are recalculated, the following ones are shifted.
+	constexpr void update(std::span<const char8_t> bytes, std::size_t offset, std::size_t removed,
+			      std::size_t inserted)
+	{
+		if (checkpoints_.size() == 1) { // The buffer was empty, there is nothing to keep.
+			*this = index{bytes, spacing_};
+			return;
+		}
+
+		bytes_ = bytes;
+
+		// Whether a position is a unit boundary depends on the byte at that position and the three preceding
+		// ones only. Hence, checkpoints before the edit, and from three bytes after it, remain at unit
+		// boundaries.
+		const auto last = std::prev(checkpoints_.end());
+		const auto first_changed = std::ranges::partition_point(checkpoints_.begin() + 1, last,
+									[=](checkpoint c) { return c.byte < offset; });
+		const auto first_kept = std::ranges::partition_point(first_changed, last, [=](checkpoint c) {
+			return c.byte < offset + removed + detail::max_unit_length - 1;
+		});
+
+		std::vector<checkpoint> checkpoints{checkpoints_.begin(), first_changed};
+		checkpoints.reserve(checkpoints_.size() + inserted / spacing_ + 1);
+
+		// The code points from the last checkpoint before the edit to the first one after it are counted again.
+		const auto old_anchor = *first_kept;
+		add_checkpoints(checkpoints.back(), old_anchor.byte - removed + inserted, checkpoints);
+		const auto new_anchor = checkpoints.back();
+
+		for (auto it = std::next(first_kept); it != checkpoints_.end(); ++it) {
+			checkpoints.push_back({it->byte - old_anchor.byte + new_anchor.byte,
+					       it->code_point - old_anchor.code_point + new_anchor.code_point});
+		}
+
+		checkpoints_ = std::move(checkpoints);
+	}
+};
+
+} // namespace utf8
@@ -0,0 +1,202 @@
+#pragma once
+
+#include "utf-8/count.h"
+#include "utf-8/detail/units.h"
+#include "utf-8/transcode.h"
+#include "utf-8/validate.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Multi-threaded entry points for large contiguous UTF-8 sequences. A sequence is split into chunks at unit boundaries
+// (see utf-8/detail/units.h), hence into chunks which utf8::decoder decodes independently into exactly the code points
+// it decodes the whole sequence into. Every chunk is then processed by the sequential function, on its own thread.
+
+namespace utf8 {
+
+namespace detail {
+
+/// @brief Minimum size of the chunks processed by parallel functions, below which threads cost more than they save
+constexpr inline std::size_t parallel_chunk_size = 0x100000;
+
+/// @brief Split a sequence into chunks at unit boundaries, one per thread
+///
+/// @param bytes The sequence
+/// @param threads The maximum number of threads, or 0 for as many as the hardware supports
+///
+/// @return The chunks, in order, of roughly the same size and at least utf8::detail::parallel_chunk_size bytes
+inline auto split_at_units(std::span<const char8_t> bytes, std::size_t threads) -> std::vector<std::span<const char8_t>>
+{
+	if (threads == 0) {
+		threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+	}
+	const auto count = std::clamp<std::size_t>(bytes.size() / parallel_chunk_size, 1, threads);
+
+	std::vector<std::span<const char8_t>> chunks;
+	chunks.reserve(count);
+
+	std::size_t start{};
+	for (std::size_t i = 1; i <= count; ++i) {
+		// Units span at most four bytes, so a unit boundary is never further back.
+		auto end = bytes.size() / count * i;
+		end = i == count ? bytes.size() : end;
+		while (not is_unit_boundary(bytes, end)) {
+			--end;
+		}
+
+		chunks.push_back(bytes.subspan(start, end - start));
+		start = end;
+	}
+
+	return chunks;
+}
+
+/// @brief Run a function for every index of a range, each on its own thread but the first one
+///
+/// @param count The size of the range
+/// @param function The function, taking an index
+template <typename F>
+void on_threads(std::size_t count, F function)
+{
+	// Workers join when they go out of scope.
+	std::vector<std::jthread> workers;
+	workers.reserve(count);
+	for (std::size_t i = 1; i < count; ++i) {
+		workers.emplace_back([&, i] { function(i); });
+	}
+	if (count != 0) {
+		function(0);
+	}
+}
+
+/// @brief Apply a function to the chunks of a sequence, each on its own thread but the first one
+///
+/// @param bytes The sequence
+/// @param threads The maximum number of threads, or 0 for as many as the hardware supports
+/// @param function The function, taking a chunk
+///
+/// @return The results of the function, in the order of the chunks, and the chunks
+template <typename F>
+auto for_each_chunk(std::span<const char8_t> bytes, std::size_t threads, F function)
+{
+	using result = std::invoke_result_t<F &, std::span<const char8_t>>;
+
+	struct results {
+		std::vector<std::span<const char8_t>> chunks;
+		std::vector<result> values;
+	};
+
+	results out{split_at_units(bytes, threads), {}};
+	out.values.resize(out.chunks.size());
+	on_threads(out.chunks.size(), [&](std::size_t i) { out.values[i] = function(out.chunks[i]); });
+
+	return out;
+}
+
+} // namespace detail
+
+/// @brief Find the first error of a contiguous UTF-8 sequence, on multiple threads
+///
+/// @param bytes The UTF-8 sequence
+/// @param threads The maximum number of threads, or 0 for as many as the hardware supports
+///
+/// @return Exactly what utf8::find_first_error returns
+///
+/// @note Every chunk of the sequence, split at unit boundaries, is searched by utf8::find_first_error on its own
+/// thread, and the first chunk in error holds the first error.
+inline auto parallel_find_first_error(std::span<const char8_t> bytes, std::size_t threads = 0) -> std::size_t
+{
+	const auto [chunks, errors] = detail::for_each_chunk(bytes, threads, [](std::span<const char8_t> chunk) {
+		return find_first_error(chunk);
+	});
+
+	std::size_t offset{};
+	for (std::size_t i = 0; i < chunks.size(); ++i) {
+		if (errors[i] != chunks[i].size()) {
+			return offset + errors[i];
+		}
+		offset += chunks[i].size();
+	}
+
+	return bytes.size();
+}
+
+/// @brief Validate a contiguous UTF-8 sequence, on multiple threads
+///
+/// @param bytes The UTF-8 sequence
+/// @param threads The maximum number of threads, or 0 for as many as the hardware supports
+///
+/// @return True if the sequence is valid UTF-8, false otherwise
+inline auto parallel_validate(std::span<const char8_t> bytes, std::size_t threads = 0) -> bool
+{
+	// Results are bytes, since threads cannot write the bits of a std::vector<bool> concurrently.
+	const auto [chunks, valid] = detail::for_each_chunk(bytes, threads, [](std::span<const char8_t> chunk) {
+		return static_cast<unsigned char>(validate(chunk));
+	});
+
+	return std::ranges::all_of(valid, [](unsigned char chunk_valid) { return chunk_valid != 0; });
+}
+
+/// @brief Count the code points of a contiguous UTF-8 sequence, on multiple threads
+///
+/// @param bytes The UTF-8 sequence
+/// @param threads The maximum number of threads, or 0 for as many as the hardware supports
+///
+/// @return Exactly what utf8::count_code_points returns
+inline auto parallel_count_code_points(std::span<const char8_t> bytes, std::size_t threads = 0) -> std::size_t
+{
+	const auto [chunks, counts] = detail::for_each_chunk(bytes, threads, [](std::span<const char8_t> chunk) {
+		return count_code_points(chunk);
+	});
+
+	std::size_t count{};
+	for (const auto chunk_count : counts) {
+		count += chunk_count;
+	}
+
+	return count;
+}
+
+/// @brief Decode a contiguous UTF-8 sequence into code points, on multiple threads
+///
+/// @param bytes The UTF-8 sequence
+/// @param code_points The output buffer, with room for at least as many code points as there are bytes, or as
+/// utf8::parallel_count_code_points returns
+/// @param threads The maximum number of threads, or 0 for as many as the hardware supports
+///
+/// @return The number of code points written, which are exactly the ones utf8::to_utf32 writes
+///
+/// @note Decoding takes two passes over the sequence. The code points of every chunk of the sequence, split at unit
+/// boundaries, are counted first, which gives the offset of every chunk in the output. Then, every chunk is decoded by
+/// utf8::decode_into, straight into its slice of the output.
+inline auto parallel_to_utf32(std::span<const char8_t> bytes, std::span<char32_t> code_points, std::size_t threads = 0)
+    -> std::size_t
+{
+	const auto chunks = detail::split_at_units(bytes, threads);
+	if (chunks.size() == 1 and code_points.size() >= bytes.size()) {
+		return to_utf32(bytes, code_points); // Without the counting pass
+	}
+
+	std::vector<std::size_t> offsets(chunks.size() + 1);
+	detail::on_threads(chunks.size(), [&](std::size_t i) { offsets[i + 1] = count_code_points(chunks[i]); });
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+	detail::on_threads(chunks.size(), [&](std::size_t i) {
+		// A chunk ends at a unit boundary, so it is only concluded by a replacement character if the whole
+		// sequence is, for the same unit in error.
+		const auto slice = code_points.subspan(offsets[i], offsets[i + 1] - offsets[i]);
+		const auto result = decode_into(chunks[i], slice);
+		if (const auto code = result.state.check_last_error()) {
+			slice[result.produced] = static_cast<char32_t>(*code);
+		}
+	});
+
+	return offsets.back();
+}
+
+} // namespace utf8
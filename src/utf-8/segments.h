@@ -0,0 +1,109 @@
+#pragma once
+
+#include "utf-8/decoder.h"
+#include "utf-8/detail/scalar.h"
+#include "utf-8/transcode.h"
+#include "utf-8/validate.h"
+#include "utf-8/validator.h"
+
+#include <cstddef>
+#include <span>
+
+// Entry points for UTF-8 sequences split into segments which are not contiguous with each other, e.g. the buffers of an
+// iovec list, or the two parts of a ring buffer. Segments are processed in place, without any copy, and characters
+// straddling two segments are carried by the decoder or validator state.
+
+namespace utf8 {
+
+/// @brief A UTF-8 sequence split into segments, in order
+using segments = std::span<const std::span<const char8_t>>;
+
+namespace detail {
+
+/// @brief Decode a segmented UTF-8 sequence, see utf8::to_utf32 and utf8::to_utf16
+template <utf_code_unit Char>
+constexpr auto transcode(segments bytes, std::span<Char> out) -> std::size_t
+{
+	std::size_t produced{};
+	decoder state{};
+
+	// Since the output has room for the whole sequence, every segment is consumed whole.
+	for (const auto segment : bytes) {
+		const auto result = decode_into(segment, out.subspan(produced), state);
+		produced += result.produced;
+		state = result.state;
+	}
+	if (const auto code = state.check_last_error()) {
+		out[produced++] = static_cast<Char>(*code);
+	}
+
+	return produced;
+}
+
+} // namespace detail
+
+/// @brief Validate a segmented UTF-8 sequence
+///
+/// @param bytes The segments of the UTF-8 sequence
+///
+/// @return True if the sequence, i.e. the concatenation of the segments, is valid UTF-8, false otherwise
+///
+/// @note Every segment is validated by utf8::validate, hence with the SIMD kernels at run time, but for the bytes of
+/// the characters straddling segment boundaries, which are validated one at a time.
+constexpr auto validate(segments bytes) -> bool
+{
+	validator state{};
+
+	for (auto segment : bytes) {
+		// The character started by the previous segment, if any, is completed first.
+		while (state.check_last_error() and not segment.empty()) {
+			if (not state.validate(segment.front())) {
+				return false;
+			}
+			segment = segment.subspan(1);
+		}
+
+		// The rest starts at a character boundary, and the character it leaves incomplete, if any, is carried.
+		const auto body = detail::scalar::complete_prefix(segment);
+		if (not validate(segment.first(body))) {
+			return false;
+		}
+		for (const auto byte : segment.subspan(body)) {
+			if (not state.validate(byte)) {
+				return false;
+			}
+		}
+	}
+
+	return not state.check_last_error();
+}
+
+/// @brief Decode a segmented UTF-8 sequence into code points
+///
+/// @param bytes The segments of the UTF-8 sequence
+/// @param code_points The output buffer, with room for at least as many code points as there are bytes in all segments
+///
+/// @return The number of code points written
+///
+/// @note Code points are exactly the ones utf8::decoder would produce for the concatenation of the segments, including
+/// replacement characters for errors. Every segment is decoded by utf8::decode_into, hence with the SIMD kernels at run
+/// time.
+constexpr auto to_utf32(segments bytes, std::span<char32_t> code_points) -> std::size_t
+{
+	return detail::transcode(bytes, code_points);
+}
+
+/// @brief Transcode a segmented UTF-8 sequence into UTF-16
+///
+/// @param bytes The segments of the UTF-8 sequence
+/// @param code_units The output buffer, with room for at least as many code units as there are bytes in all segments
+///
+/// @return The number of code units written
+///
+/// @note Same as the UTF-32 overload, with code points beyond the Basic Multilingual Plane written as surrogate pairs.
+constexpr auto to_utf16(segments bytes, std::span<char16_t> code_units) -> std::size_t
+{
+	return detail::transcode(bytes, code_units);
+}
+
+} // namespace utf8
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "utf-8/decoder.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+namespace utf8 {
+
+/// @brief UTF-8 decoder, one byte at a time, with a "shift DFA"
+///
+/// This decoder has the exact same interface and semantics as utf8::decoder, and runs the exact same FSM, but with
+/// another representation of it: every byte value maps to a 64-bit word packing, for every state, the next state on
+/// reception of that byte. States are represented by their bit offset in those words, so that a transition is one
+/// table load and one shift, instead of two dependent table loads (character class, then next state). The payload mask
+/// of the byte when it is a start byte is packed in the same word.
+///
+/// See https://gist.github.com/pervognsen/218ea17743e1442e59bb60d29b1aa725 for the technique.
+class shift_decoder {
+	static constexpr auto state_width = 6;
+	static constexpr uint64_t state_mask = (uint64_t{1} << state_width) - 1;
+	static constexpr auto payload_mask_shift = 56;
+	static constexpr uint8_t start_ = 0;
+	static constexpr uint8_t error_ = static_cast<uint8_t>(decoder::state::error) * state_width;
+	static constexpr unsigned long replacement_char_ = decoder::replacement_char_;
+
+	// The following table contains, for every byte value, the next states from all states but the error state, at
+	// the bit offsets which represent them, and the payload mask for start bytes in the highest byte.
+	static constexpr std::array<uint64_t, 0x100> transitions_ = [] {
+		std::array<uint64_t, 0x100> transitions{};
+
+		for (unsigned int byte = 0; byte < transitions.size(); ++byte) {
+			const auto type = decoder::char_classes_.at(byte);
+			auto &row = transitions.at(byte);
+
+			for (uint8_t s = 0; s < static_cast<uint8_t>(decoder::state::error); ++s) {
+				const auto next = decoder::next_state(static_cast<decoder::state>(s), type);
+				const auto offset = static_cast<uint64_t>(static_cast<uint8_t>(next) * state_width);
+				row |= offset << (s * state_width);
+			}
+
+			row |= uint64_t{decoder::start_byte_payload(0xff, type)} << payload_mask_shift;
+		}
+
+		return transitions;
+	}();
+
+	unsigned long code_{};
+	uint8_t state_{start_};
+
+	enum class to_deliver { nothing, code_point, error };
+
+	to_deliver to_deliver_{};
+
+	/// @brief Calculate next state
+	///
+	/// @param row The transitions for the received byte
+	/// @param s Current state
+	///
+	/// @return The next state
+	constexpr static auto next_state(uint64_t row, uint8_t s) -> uint8_t
+	{
+		return static_cast<uint8_t>((row >> s) & state_mask);
+	}
+
+	/// @brief Extract payload from start byte
+	///
+	/// @param row The transitions for the start byte
+	/// @param byte The start byte
+	///
+	/// @return The payload
+	constexpr static auto start_byte_payload(uint64_t row, uint8_t byte) -> uint8_t
+	{
+		return byte & static_cast<uint8_t>(row >> payload_mask_shift);
+	}
+
+public:
+	/// @brief Decode one byte
+	///
+	/// @param byte The byte to decode
+	///
+	/// @return A decoded code point if there is one or nothing otherwise
+	///
+	/// @warning As with utf8::decoder, if this function returns something, the invoker shall once invoke the fetch
+	/// function.
+	constexpr auto decode(char8_t byte) -> std::optional<unsigned long>
+	{
+		const auto row = transitions_.at(byte);
+
+		static constexpr auto data_mask = 0x3f;
+		static constexpr auto data_shift = 6;
+
+		to_deliver_ = to_deliver::nothing;
+
+		const auto new_state = next_state(row, state_);
+
+		if (new_state == error_) {
+			if (state_ == start_) { // single byte in error
+				return replacement_char_;
+			}
+			state_ = next_state(row, start_);
+			if (state_ == error_) { // interruption by byte in error
+				state_ = start_;
+				to_deliver_ = to_deliver::error;
+				return replacement_char_;
+			}
+			code_ = start_byte_payload(row, byte);
+			if (state_ == start_) { // interruption by single-byte code point
+				to_deliver_ = to_deliver::code_point;
+			}
+			return replacement_char_; // or interruption by multi-byte start byte
+		}
+
+		code_ = (state_ == start_) ? start_byte_payload(row, byte) : (code_ << data_shift) | (byte & data_mask);
+		state_ = new_state;
+
+		if (state_ == start_) {
+			return code_;
+		}
+
+		return {};
+	}
+
+	/// @brief Fetch any extra decoded code point
+	///
+	/// @return An extra decoded code point if there is one or nothing otherwise
+	constexpr auto fetch() -> std::optional<unsigned long>
+	{
+		const auto code = to_deliver_ == to_deliver::code_point ? std::optional{code_}
+				  : to_deliver_ == to_deliver::error	? std::optional{replacement_char_}
+									: std::nullopt;
+
+		to_deliver_ = to_deliver::nothing;
+		return code;
+	}
+
+	/// @brief Check for error at the end of the UTF-8 sequence
+	///
+	/// @return Replacement character in case of error or nothing otherwise
+	///
+	/// @note See utf8::decoder::check_last_error.
+	[[nodiscard]] constexpr auto check_last_error() const -> std::optional<unsigned long>
+	{
+		return state_ != start_ ? std::optional{replacement_char_} : std::nullopt;
+	}
+};
+
+} // namespace utf8
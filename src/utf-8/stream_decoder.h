@@ -0,0 +1,92 @@
+#pragma once
+
+#include "utf-8/decoder.h"
+#include "utf-8/transcode.h"
+
+#include <cstddef>
+#include <optional>
+#include <span>
+
+namespace utf8 {
+
+/// @brief UTF-8 decoder, one chunk at a time
+///
+/// For sequences received in chunks, e.g. from a socket, of which characters may straddle two chunks. Every chunk is
+/// decoded at once, with the bulk transcoding kernels, and only the decoder state of a character left incomplete at the
+/// end of a chunk is kept until the next one. The code points of a whole sequence are exactly the ones utf8::decoder
+/// produces, however the sequence is split, provided that utf8::stream_decoder::finish is called after the last chunk.
+class stream_decoder {
+public:
+	/// @brief Result of the decoding of a chunk
+	struct result {
+		std::size_t consumed{}; ///< Number of bytes consumed from the chunk
+		std::size_t produced{}; ///< Number of code points, or UTF-16 code units, written to the output
+	};
+
+private:
+	decoder state_{};
+
+	/// @brief Decode a chunk as far as the output allows, and keep the state to resume with
+	template <detail::utf_code_unit Char>
+	constexpr auto decode_chunk(std::span<const char8_t> chunk, std::span<Char> out) -> result
+	{
+		const auto decoded = detail::decode_into(chunk, out, state_);
+		state_ = decoded.state;
+		return {decoded.consumed, decoded.produced};
+	}
+
+public:
+	/// @brief Calculate the room needed to decode a chunk
+	///
+	/// @param bytes The size of the chunk
+	///
+	/// @return The number of code points, or UTF-16 code units, the decoding of the chunk may produce at most
+	///
+	/// @note Every byte produces at most one code unit, net of the ones produced by previous bytes of its maximal
+	/// subpart, and the character left incomplete by the previous chunk, if any, produces at most one more.
+	static constexpr auto max_length(std::size_t bytes) -> std::size_t { return bytes + 1; }
+
+	/// @brief Decode a chunk into code points
+	///
+	/// @param chunk The next chunk of the sequence
+	/// @param code_points The output buffer, with room for utf8::stream_decoder::max_length code points
+	///
+	/// @return The number of bytes consumed and of code points written
+	///
+	/// @note The whole chunk is consumed if the output has room for utf8::stream_decoder::max_length code points.
+	/// Otherwise, decoding stops when the output is full, and shall resume with the bytes left.
+	constexpr auto decode(std::span<const char8_t> chunk, std::span<char32_t> code_points) -> result
+	{
+		return decode_chunk(chunk, code_points);
+	}
+
+	/// @brief Decode a chunk into UTF-16
+	///
+	/// @param chunk The next chunk of the sequence
+	/// @param code_units The output buffer, with room for utf8::stream_decoder::max_length code units
+	///
+	/// @return The number of bytes consumed and of code units written
+	///
+	/// @note Same as the UTF-32 overload. Surrogate pairs are never split across chunks, nor across outputs.
+	constexpr auto decode(std::span<const char8_t> chunk, std::span<char16_t> code_units) -> result
+	{
+		return decode_chunk(chunk, code_units);
+	}
+
+	/// @brief Check whether a character is left incomplete by the chunks decoded so far
+	[[nodiscard]] constexpr auto pending() const -> bool { return state_.check_last_error().has_value(); }
+
+	/// @brief Conclude the sequence, see utf8::decoder::check_last_error
+	///
+	/// @return Replacement character if the sequence ends with an incomplete character, or nothing otherwise
+	///
+	/// @note The decoder is then ready for another sequence.
+	constexpr auto finish() -> std::optional<unsigned long>
+	{
+		const auto code = state_.check_last_error();
+		state_ = {};
+		return code;
+	}
+};
+
+} // namespace utf8
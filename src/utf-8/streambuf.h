@@ -0,0 +1,226 @@
+#pragma once
+
+#include "utf-8/detail/scalar.h"
+#include "utf-8/stream_decoder.h"
+#include "utf-8/transcode.h"
+#include "utf-8/validate.h"
+#include "utf-8/validator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <streambuf>
+#include <vector>
+
+// Stream buffers which decode or validate the UTF-8 read from another stream buffer, for code consuming streams. Both
+// read large chunks from their source at once, and process every chunk in bulk, with the SIMD kernels at run time.
+
+namespace utf8 {
+
+namespace detail {
+
+/// @brief Default size of the chunks read from the source of a stream buffer, in bytes
+constexpr inline std::size_t streambuf_chunk_size = 0x10000;
+
+/// @brief Read a chunk from a stream buffer
+///
+/// @param source The stream buffer
+/// @param bytes The chunk
+///
+/// @return The number of bytes read, 0 at the end of the source only
+inline auto read_chunk(std::streambuf &source, std::span<char8_t> bytes) -> std::size_t
+{
+	// Bytes may be written as char, which may alias anything.
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	auto *data = reinterpret_cast<char *>(bytes.data());
+
+	return static_cast<std::size_t>(source.sgetn(data, static_cast<std::streamsize>(bytes.size())));
+}
+
+} // namespace detail
+
+/// @brief Input stream buffer decoding UTF-8 from another stream buffer
+/// @tparam Char The code unit type, char32_t for code points or char16_t for UTF-16
+///
+/// Code units are exactly the ones utf8::to_utf32 or utf8::to_utf16 produce for the whole sequence the source holds,
+/// including replacement characters for errors, when read in blocks, through sgetn or std::basic_istream::read. The
+/// source is read in chunks, decoded by a utf8::stream_decoder, so that characters straddling two chunks are only
+/// carried as decoder state.
+///
+/// @note Seeking is not supported.
+///
+/// @warning For char16_t, code units read one at a time, through sgetc, sbumpc, std::istreambuf_iterator or
+/// std::basic_istream::get, go through std::char_traits<char16_t>::to_int_type, which cannot represent U+FFFF, the
+/// value of its eof: libstdc++ turns U+FFFF into U+FFFD, and libc++ reads it as the end of the stream.
+template <detail::utf_code_unit Char = char32_t>
+class decoding_streambuf : public std::basic_streambuf<Char> {
+	using traits = typename std::basic_streambuf<Char>::traits_type;
+
+	std::streambuf *source_;
+	std::vector<char8_t> bytes_;
+	std::vector<Char> code_units_;
+	stream_decoder decoder_{};
+	bool finished_{};
+
+	/// @brief Decode the next chunk of the source which produces code units, if any, into the get area
+	///
+	/// @return Whether the get area holds code units
+	///
+	/// @note Code units are never converted to int_type here, so that U+FFFF is kept.
+	auto refill() -> bool
+	{
+		std::size_t produced{};
+
+		// A chunk may end in the middle of a character, and produce nothing.
+		while (produced == 0 and not finished_) {
+			if (const auto size = detail::read_chunk(*source_, bytes_); size != 0) {
+				produced = decoder_.decode(std::span{bytes_}.first(size), code_units_).produced;
+			} else {
+				finished_ = true;
+				if (const auto code = decoder_.finish()) {
+					code_units_[produced++] = static_cast<Char>(*code);
+				}
+			}
+		}
+
+		this->setg(code_units_.data(), code_units_.data(), code_units_.data() + produced);
+		return produced != 0;
+	}
+
+protected:
+	auto underflow() -> typename traits::int_type override
+	{
+		if (this->gptr() == this->egptr()) {
+			refill();
+		}
+
+		return this->gptr() == this->egptr() ? traits::eof() : traits::to_int_type(*this->gptr());
+	}
+
+	// Blocks are copied from the get area, rather than through uflow for the first code unit of every chunk, as the
+	// default does, since traits::to_int_type would turn U+FFFF into U+FFFD.
+	auto xsgetn(Char *data, std::streamsize count) -> std::streamsize override
+	{
+		std::streamsize copied{};
+		while (copied < count and (this->gptr() != this->egptr() or refill())) {
+			const auto size = std::min<std::streamsize>(count - copied, this->egptr() - this->gptr());
+			std::copy_n(this->gptr(), size, data + copied);
+			this->setg(this->eback(), this->gptr() + size, this->egptr());
+			copied += size;
+		}
+
+		return copied;
+	}
+
+public:
+	/// @brief Create a stream buffer
+	///
+	/// @param source The stream buffer to read UTF-8 from, which shall outlive this one
+	/// @param chunk_size The number of bytes read from the source at once
+	explicit decoding_streambuf(std::streambuf &source, std::size_t chunk_size = detail::streambuf_chunk_size)
+	    : source_{&source}, bytes_(std::max<std::size_t>(chunk_size, 1)),
+	      code_units_(stream_decoder::max_length(bytes_.size()))
+	{
+	}
+};
+
+/// @brief Input stream buffer passing the bytes of another stream buffer through, and validating them as UTF-8
+///
+/// Bytes are passed unchanged, including errors, and the offset of the first error is available as soon as the chunk
+/// holding it is read. The source is read in chunks, every one of which is validated by utf8::find_first_error but for
+/// the bytes of the characters straddling two chunks, which are validated one at a time.
+///
+/// @note Seeking is not supported.
+class validating_streambuf : public std::streambuf {
+	std::streambuf *source_;
+	std::vector<char8_t> bytes_;
+	validator state_{};
+	std::size_t offset_{};    // Of the current chunk in the sequence
+	std::size_t character_{}; // Offset of the character the validator is in the middle of, if any
+	std::optional<std::size_t> first_error_;
+	bool finished_{};
+
+	/// @brief Validate a chunk, unless an error was found already
+	///
+	/// @param chunk The chunk, starting at offset_
+	void validate_chunk(std::span<const char8_t> chunk)
+	{
+		std::size_t i{};
+		const auto validate_byte = [&] {
+			if (not state_.check_last_error()) {
+				character_ = offset_ + i;
+			}
+			if (not state_.validate(chunk[i++])) {
+				first_error_ = character_;
+			}
+		};
+
+		// The character started by the previous chunk, if any, is completed first.
+		while (not first_error_.has_value() and state_.check_last_error() and i < chunk.size()) {
+			validate_byte();
+		}
+		if (first_error_.has_value()) {
+			return;
+		}
+
+		// The rest starts at a character boundary, and the character it leaves incomplete, if any, is carried.
+		const auto body = chunk.subspan(i, detail::scalar::complete_prefix(chunk.subspan(i)));
+		if (const auto error = find_first_error(body); error != body.size()) {
+			first_error_ = offset_ + i + error;
+			return;
+		}
+		for (i += body.size(); not first_error_.has_value() and i < chunk.size();) {
+			validate_byte();
+		}
+	}
+
+protected:
+	auto underflow() -> int_type override
+	{
+		if (gptr() == egptr() and not finished_) {
+			const auto size = detail::read_chunk(*source_, bytes_);
+			const auto chunk = std::span{bytes_}.first(size);
+
+			if (not first_error_.has_value()) {
+				validate_chunk(chunk);
+			}
+			offset_ += size;
+
+			if (size == 0) {
+				finished_ = true;
+				if (not first_error_.has_value() and state_.check_last_error()) {
+					first_error_ = character_;
+				}
+			}
+
+			// Bytes may be read as char, which may alias anything.
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			auto *data = reinterpret_cast<char *>(bytes_.data());
+			setg(data, data, data + size);
+		}
+
+		return gptr() == egptr() ? traits_type::eof() : traits_type::to_int_type(*gptr());
+	}
+
+public:
+	/// @brief Create a stream buffer
+	///
+	/// @param source The stream buffer to read UTF-8 from, which shall outlive this one
+	/// @param chunk_size The number of bytes read from the source at once
+	explicit validating_streambuf(std::streambuf &source, std::size_t chunk_size = detail::streambuf_chunk_size)
+	    : source_{&source}, bytes_(std::max<std::size_t>(chunk_size, 1))
+	{
+	}
+
+	/// @brief Get the offset of the first error read so far
+	///
+	/// @return The offset in the sequence of the first maximal subpart in error, see utf8::find_first_error, or
+	/// nothing if the bytes read so far are valid
+	///
+	/// @note Errors are found a chunk at a time, hence possibly before the bytes in error are consumed, and a
+	/// sequence truncated in the middle of a character is only known to be once the end of the source is reached.
+	[[nodiscard]] auto first_error() const -> std::optional<std::size_t> { return first_error_; }
+};
+
+} // namespace utf8
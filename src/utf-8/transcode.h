@@ -0,0 +1,296 @@
+#pragma once
+
+#include "utf-8/decoder.h"
+#include "utf-8/detail/dispatch.h"
+#include "utf-8/detail/scalar.h"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <span>
+
+namespace utf8 {
+
+/// @brief Result of the decoding of a UTF-8 sequence chunk
+struct decode_result {
+	std::size_t consumed{}; ///< Number of bytes consumed from the input
+	std::size_t produced{}; ///< Number of code points, or UTF-16 code units, written to the output
+	decoder state{};	///< Decoder state to resume decoding with, at the next byte
+};
+
+namespace detail {
+
+template <typename T>
+concept utf_code_unit = std::same_as<T, char32_t> or std::same_as<T, char16_t>;
+
+/// @brief Number of code units encoding a code point
+template <utf_code_unit Char>
+constexpr auto code_units(unsigned long code) -> std::size_t
+{
+	static constexpr unsigned long last_bmp = 0xffff;
+
+	return std::same_as<Char, char16_t> and code > last_bmp ? 2 : 1;
+}
+
+/// @brief Run the bulk transcoding kernel for an output encoding
+///
+/// @param bytes The UTF-8 sequence, starting at a character boundary
+/// @param out The output, with room for at least as many code units as there are bytes
+/// @param window Set to the number of bytes to decode without the kernel if it makes no progress
+///
+/// @return The number of bytes consumed and of code units produced
+template <utf_code_unit Char>
+constexpr auto transcode_bulk(std::span<const char8_t> bytes, Char *out, std::size_t &window) -> transcode_result
+{
+	if consteval {
+		window = 1;
+		if constexpr (std::same_as<Char, char16_t>) {
+			return scalar::to_utf16(bytes, out);
+		} else {
+			return scalar::to_utf32(bytes, out);
+		}
+	} else {
+		const auto &kernels = active_kernels();
+		window = kernels.window;
+		if constexpr (std::same_as<Char, char16_t>) {
+			return kernels.to_utf16(bytes, out);
+		} else {
+			return kernels.to_utf32(bytes, out);
+		}
+	}
+}
+
+/// @brief Decode a contiguous UTF-8 sequence chunk, see utf8::decode_into
+template <utf_code_unit Char>
+constexpr auto decode_into(std::span<const char8_t> bytes, std::span<Char> out, decoder state) -> decode_result
+{
+	std::size_t consumed{};
+	std::size_t produced{};
+
+	const auto output = [&](unsigned long code) {
+		if constexpr (std::same_as<Char, char16_t>) {
+			produced += encode_utf16(code, out.data() + produced);
+		} else {
+			out[produced++] = static_cast<char32_t>(code);
+		}
+	};
+
+	// Bytes from there are decoded one at a time, since the bulk kernels made no progress on them.
+	std::size_t fallback_end{};
+
+	// As long as there is room for the two code units a byte may produce, no check is needed.
+	while (consumed < bytes.size() and out.size() - produced >= 2) {
+		// At character boundaries, the bulk kernels transcode as much as they can.
+		if (consumed >= fallback_end and not state.check_last_error().has_value()) {
+			const auto room = out.size() - produced;
+			const auto chunk = bytes.subspan(consumed, std::min(bytes.size() - consumed, room));
+			std::size_t window{};
+			const auto result = transcode_bulk(chunk, out.data() + produced, window);
+
+			consumed += result.consumed;
+			produced += result.produced;
+			if (result.consumed != 0) {
+				continue;
+			}
+			fallback_end = consumed + window;
+		}
+
+		if (const auto code = state.decode(bytes[consumed++])) {
+			output(*code);
+			if (const auto extra = state.fetch()) {
+				output(*extra);
+			}
+		}
+	}
+
+	// Otherwise, a byte is only consumed if everything it produces fits.
+	while (consumed < bytes.size()) {
+		auto next_state = state;
+		const auto code = next_state.decode(bytes[consumed]);
+		const auto extra = code.has_value() ? next_state.fetch() : std::nullopt;
+		const auto size = (code.has_value() ? code_units<Char>(*code) : 0) +
+				  (extra.has_value() ? code_units<Char>(*extra) : 0);
+
+		if (size > out.size() - produced) {
+			break;
+		}
+
+		state = next_state;
+		++consumed;
+		if (code.has_value()) {
+			output(*code);
+		}
+		if (extra.has_value()) {
+			output(*extra);
+		}
+	}
+
+	return {consumed, produced, state};
+}
+
+/// @brief Decode a whole contiguous UTF-8 sequence, see utf8::to_utf32 and utf8::to_utf16
+template <utf_code_unit Char>
+constexpr auto transcode(std::span<const char8_t> bytes, std::span<Char> out) -> std::size_t
+{
+	// Every byte produces at most one code unit, net of the ones produced by previous bytes of its maximal subpart.
+	const auto result = decode_into(bytes, out.first(bytes.size()), decoder{});
+	auto produced = result.produced;
+
+	if (const auto code = result.state.check_last_error()) {
+		out[produced++] = static_cast<Char>(*code);
+	}
+
+	return produced;
+}
+
+} // namespace detail
+
+/// @brief Decode a contiguous UTF-8 sequence chunk into code points
+///
+/// @param bytes The UTF-8 sequence chunk
+/// @param code_points The output buffer
+/// @param state The decoder state at the beginning of the chunk, i.e. the state returned by the decoding of the
+/// previous chunk, if any
+///
+/// @return How far decoding went, and the decoder state to resume with
+///
+/// @note Decoding stops at the end of the input, or as soon as what the next byte produces does not fit in the output.
+/// Hence, progress is guaranteed as long as the output has room for two code points. Code points are exactly the ones
+/// utf8::decoder would produce, including replacement characters for maximal subparts in error, except for the one
+/// utf8::decoder::check_last_error would produce at the end of the sequence: the invoker shall call that function on
+/// the returned state when there is no more chunk. At run time, valid parts of the sequence are transcoded 64 bytes at
+/// a time, with the most capable of SSE4.2 and AVX2 that the CPU supports.
+constexpr auto decode_into(std::span<const char8_t> bytes, std::span<char32_t> code_points, decoder state = {})
+    -> decode_result
+{
+	return detail::decode_into(bytes, code_points, state);
+}
+
+/// @brief Decode a contiguous UTF-8 sequence chunk into UTF-16
+///
+/// @param bytes The UTF-8 sequence chunk
+/// @param code_units The output buffer
+/// @param state The decoder state at the beginning of the chunk, i.e. the state returned by the decoding of the
+/// previous chunk, if any
+///
+/// @return How far decoding went, and the decoder state to resume with
+///
+/// @note Same as the UTF-32 overload, with code points beyond the Basic Multilingual Plane written as surrogate pairs,
+/// which are never split across chunks. Progress is guaranteed as long as the output has room for two code units.
+constexpr auto decode_into(std::span<const char8_t> bytes, std::span<char16_t> code_units, decoder state = {})
+    -> decode_result
+{
+	return detail::decode_into(bytes, code_units, state);
+}
+
+/// @brief Decode a contiguous UTF-8 sequence into code points
+///
+/// @param bytes The UTF-8 sequence
+/// @param code_points The output buffer, with room for at least as many code points as there are bytes
+///
+/// @return The number of code points written
+///
+/// @note Code points are exactly the ones utf8::decoder would produce, including replacement characters for errors.
+constexpr auto to_utf32(std::span<const char8_t> bytes, std::span<char32_t> code_points) -> std::size_t
+{
+	return detail::transcode(bytes, code_points);
+}
+
+/// @brief Calculate the length of a UTF-8 sequence in UTF-16
+///
+/// @param bytes The UTF-8 sequence
+///
+/// @return The exact number of code units utf8::to_utf16 writes for the sequence
+///
+/// @note At run time, valid parts of the sequence are counted in one pass, by the code point counting kernel that
+/// utf8::count_code_points uses, plus one code unit for every four-byte character. Only the parts which are not valid
+/// are run through the decoder.
+constexpr auto utf16_length(std::span<const char8_t> bytes) -> std::size_t
+{
+	// The four-byte characters of a block are counted right after its code points, while it is in the cache.
+	static constexpr std::size_t block_size = 0x10000;
+
+	std::size_t consumed{};
+	std::size_t length{};
+	decoder state{};
+
+	// Bytes from there are decoded one at a time, since the bulk kernels made no progress on them.
+	std::size_t fallback_end{};
+
+	while (consumed < bytes.size()) {
+		// At character boundaries, the bulk kernels count as much as they can, in which every four-byte character
+		// takes a surrogate pair.
+		if (consumed >= fallback_end and not state.check_last_error().has_value()) {
+			const auto block = bytes.subspan(consumed, std::min(bytes.size() - consumed, block_size));
+			detail::transcode_result result{};
+			std::size_t window = 1;
+			if consteval {
+				result = detail::scalar::count_code_points(block);
+			} else {
+				const auto &kernels = detail::active_kernels();
+				result = kernels.count_code_points(block);
+				window = kernels.window;
+			}
+
+			const auto pairs = std::ranges::count_if(block.first(result.consumed),
+								 [](char8_t byte) { return byte >= 0xf0; });
+			consumed += result.consumed;
+			length += result.produced + static_cast<std::size_t>(pairs);
+			if (result.consumed != 0) {
+				continue;
+			}
+			fallback_end = consumed + window;
+		}
+
+		if (const auto code = state.decode(bytes[consumed++])) {
+			length += detail::code_units<char16_t>(*code);
+			if (const auto extra = state.fetch()) {
+				length += detail::code_units<char16_t>(*extra);
+			}
+		}
+	}
+	if (state.check_last_error().has_value()) {
+		++length;
+	}
+
+	return length;
+}
+
+/// @brief Transcode a contiguous UTF-8 sequence into UTF-16
+///
+/// @param bytes The UTF-8 sequence
+/// @param code_units The output buffer, with room for at least as many code units as there are bytes, or as
+/// utf8::utf16_length returns
+///
+/// @return The number of code units written
+///
+/// @note Code units encode exactly the code points utf8::decoder would produce, including replacement characters for
+/// errors.
+constexpr auto to_utf16(std::span<const char8_t> bytes, std::span<char16_t> code_units) -> std::size_t
+{
+	if (code_units.size() >= bytes.size()) {
+		return detail::transcode(bytes, code_units);
+	}
+
+	// The output is only known to be large enough as a whole, which the resumable decoding copes with.
+	std::size_t consumed{};
+	std::size_t produced{};
+	decoder state{};
+
+	while (consumed < bytes.size()) {
+		const auto result = decode_into(bytes.subspan(consumed), code_units.subspan(produced), state);
+		if (result.consumed == 0) {
+			break;
+		}
+		consumed += result.consumed;
+		produced += result.produced;
+		state = result.state;
+	}
+	if (const auto code = state.check_last_error(); code.has_value() and produced < code_units.size()) {
+		code_units[produced++] = static_cast<char16_t>(*code);
+	}
+
+	return produced;
+}
+
+} // namespace utf8
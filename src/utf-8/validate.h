@@ -0,0 +1,70 @@
+#pragma once
+
+#include "utf-8/detail/dispatch.h"
+#include "utf-8/detail/scalar.h"
+#include "utf-8/validator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+
+namespace utf8 {
+
+/// @brief Validate a contiguous UTF-8 sequence
+///
+/// @param bytes The UTF-8 sequence
+///
+/// @return True if the sequence is valid UTF-8, false otherwise
+///
+/// @note This function accepts and rejects exactly the same sequences as utf8::decoder, i.e. a sequence is valid if and
+/// only if decoding it would not produce any replacement character for an error. At run time, it validates 16, 32 or
+/// 64 bytes at a time, with the most capable of SSE4.2, AVX2 and AVX-512 that the CPU supports.
+constexpr auto validate(std::span<const char8_t> bytes) -> bool
+{
+	if consteval {
+		return detail::scalar::validate(bytes);
+	} else {
+		return detail::active_kernels().validate(bytes);
+	}
+}
+
+/// @brief Find the first error of a contiguous UTF-8 sequence
+///
+/// @param bytes The UTF-8 sequence
+///
+/// @return The offset of the first maximal subpart in error, i.e. of the bytes utf8::decoder produces its first
+/// replacement character for an error from, or the size of the sequence if it is valid
+///
+/// @note The sequence is validated by utf8::validate in blocks ending at character boundaries, and only the first block
+/// in error is run through utf8::validator, to locate the error.
+constexpr auto find_first_error(std::span<const char8_t> bytes) -> std::size_t
+{
+	static constexpr std::size_t block_size = 0x10000;
+
+	std::size_t offset{};
+	while (offset < bytes.size()) {
+		const auto block = bytes.subspan(offset, std::min(bytes.size() - offset, block_size));
+		const auto last = offset + block.size() == bytes.size();
+		const auto size = last ? block.size() : detail::scalar::complete_prefix(block);
+		if (not validate(block.first(size))) {
+			break;
+		}
+		offset += size;
+	}
+
+	validator state{};
+	auto start = offset; // Of the current subpart
+
+	for (; offset < bytes.size(); ++offset) {
+		if (not state.check_last_error()) {
+			start = offset;
+		}
+		if (not state.validate(bytes[offset])) {
+			return start;
+		}
+	}
+
+	return state.check_last_error() ? start : bytes.size();
+}
+
+} // namespace utf8
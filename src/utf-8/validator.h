@@ -0,0 +1,45 @@
+#pragma once
+
+#include "utf-8/decoder.h"
+
+namespace utf8 {
+
+/// @brief UTF-8 validator, one byte at a time
+///
+/// This validator runs the exact same FSM as utf8::decoder, but does not build any code point. Hence, it accepts and
+/// rejects exactly the same byte sequences as the decoder. Like the decoder, it resynchronizes after an error, i.e.
+/// decoding is reset at the interrupting byte.
+class validator {
+	decoder::state state_{decoder::state::start};
+
+public:
+	/// @brief Validate one byte
+	///
+	/// @param byte The byte to validate
+	///
+	/// @return False if this byte is in error or interrupts a so far legal subpart, true otherwise
+	constexpr auto validate(char8_t byte) -> bool
+	{
+		const auto type = decoder::char_classes_.at(byte);
+		const auto new_state = decoder::next_state(state_, type);
+
+		if (new_state == decoder::state::error) {
+			state_ = state_ == decoder::state::start ? decoder::state::start
+								 : decoder::next_state(decoder::state::start, type);
+			if (state_ == decoder::state::error) {
+				state_ = decoder::state::start;
+			}
+			return false;
+		}
+
+		state_ = new_state;
+		return true;
+	}
+
+	/// @brief Check for error at the end of the UTF-8 sequence
+	///
+	/// @return True if the sequence ends in the middle of a multi-byte character, false otherwise
+	[[nodiscard]] constexpr auto check_last_error() const -> bool { return state_ != decoder::state::start; }
+};
+
+} // namespace utf8
@@ -0,0 +1,149 @@
+#include "utf-8.h"
+#include "utf-8/corpus.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <random>
+#include <span>
+#include <string>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+void test_determinism()
+{
+	const utf8::corpus::options options{.seed = 42, .error_rate = 0.01};
+	const auto corpus = utf8::corpus::generate(options, 100000);
+
+	assert(corpus.size() == 100000);
+	assert(utf8::corpus::generate(options, 100000) == corpus);
+	assert(utf8::corpus::generate({.seed = 43, .error_rate = 0.01}, 100000) != corpus);
+
+	// Filling in pieces generates the same bytes as filling at once, fragments straddling pieces included.
+	std::mt19937 generator{};
+	utf8::corpus::generator whole{options};
+	utf8::corpus::generator pieces{options};
+	std::u8string expected(200000, u8'\0');
+	std::u8string bytes(expected.size(), u8'\0');
+	whole.fill(expected);
+	for (std::size_t offset = 0; offset < bytes.size();) {
+		const auto size = std::min<std::size_t>(generator() % 9, bytes.size() - offset);
+		pieces.fill(std::span{bytes}.subspan(offset, size));
+		offset += size;
+	}
+	assert(bytes == expected);
+	assert(pieces.generated().characters == whole.generated().characters);
+	assert(pieces.generated().errors == whole.generated().errors);
+}
+
+void test_lengths()
+{
+	// Without errors, corpora are valid, and end at a character boundary.
+	for (const auto &lengths : {std::array{1U, 0U, 0U, 0U}, std::array{0U, 1U, 0U, 0U}, std::array{0U, 0U, 1U, 0U},
+				    std::array{0U, 0U, 0U, 1U}}) {
+		const auto length = static_cast<std::size_t>(std::ranges::find(lengths, 1U) - lengths.begin()) + 1;
+		utf8::corpus::generator generator{{.seed = 1, .lengths = lengths}};
+		std::u8string bytes(40001, u8'\0');
+		generator.fill(bytes, true);
+
+		// The last character does not fit but for ASCII, and is replaced by a space.
+		assert(utf8::validate(bytes));
+		assert(generator.generated().characters == bytes.size() / length);
+		assert(utf8::count_code_points(bytes) == generator.generated().characters + bytes.size() % length);
+		if (length != 1) {
+			assert(bytes.back() == u8' ');
+		}
+	}
+
+	// A short complete fill completes the character the fill before left incomplete, then drops the next one.
+	for (const std::size_t size : {2, 3}) {
+		utf8::corpus::generator generator{{.seed = 1, .lengths = {0, 0, 1, 0}}};
+		std::u8string bytes(4 + size, u8'\0');
+		generator.fill(std::span{bytes}.first(4));
+		generator.fill(std::span{bytes}.subspan(4), true);
+
+		assert(utf8::validate(bytes));
+		assert(generator.generated().characters == 2);
+		assert(utf8::count_code_points(bytes) == generator.generated().characters + size - 2);
+	}
+
+	// A mix, with roughly the requested proportions
+	utf8::corpus::generator generator{{.seed = 2, .lengths = {3, 0, 1, 0}}};
+	std::u8string bytes(600000, u8'\0');
+	generator.fill(bytes, true);
+	const auto ascii = static_cast<std::size_t>(std::ranges::count_if(bytes, [](char8_t byte) {
+		return byte < 0x80;
+	}));
+	const auto characters = generator.generated().characters;
+	assert(utf8::validate(bytes) and ascii * 4 > characters * 29 / 10 and ascii * 4 < characters * 31 / 10);
+}
+
+void test_errors()
+{
+	using utf8::corpus::error;
+
+	for (const auto category : {error::overlong, error::surrogate, error::truncated, error::impossible}) {
+		std::array<unsigned, utf8::corpus::error_categories> weights{};
+		weights.at(static_cast<std::size_t>(category)) = 1;
+		utf8::corpus::generator generator{{.seed = 3, .error_rate = 1, .errors = weights}};
+		std::u8string bytes(10000, u8'\0');
+		generator.fill(bytes, true);
+
+		const auto errors = generator.generated().errors.at(static_cast<std::size_t>(category));
+		assert(generator.generated().characters == 0 and errors > 0);
+		assert(not utf8::validate(bytes) and utf8::find_first_error(bytes) == 0);
+
+		// Every error decodes to replacement characters only, one per fragment for truncated characters.
+		std::u32string code_points(bytes.size(), U'\0');
+		code_points.resize(utf8::to_utf32(bytes, code_points));
+		while (code_points.back() == U' ') {
+			code_points.pop_back();
+		}
+		assert(std::ranges::all_of(code_points, [](char32_t code) { return code == U'�'; }));
+		assert(category != error::truncated or code_points.size() == errors);
+
+		switch (category) {
+		case error::overlong:
+			assert(bytes[0] == 0xc0 or bytes[0] == 0xc1 or bytes[0] == 0xe0 or bytes[0] == 0xf0);
+			break;
+		case error::surrogate:
+			assert(bytes[0] == 0xed and bytes[1] >= 0xa0 and bytes[1] <= 0xbf);
+			break;
+		case error::truncated:
+			break;
+		case error::impossible:
+			assert(std::ranges::all_of(bytes, [](char8_t byte) {
+				return byte == 0xc0 or byte == 0xc1 or byte >= 0xf5 or byte == u8' ';
+			}));
+			break;
+		}
+	}
+
+	// Roughly the requested density
+	utf8::corpus::generator generator{{.seed = 4, .error_rate = 0.1}};
+	std::u8string bytes(1000000, u8'\0');
+	generator.fill(bytes);
+	std::size_t errors{};
+	for (const auto count : generator.generated().errors) {
+		assert(count > 0);
+		errors += count;
+	}
+	const auto fragments = errors + generator.generated().characters;
+	assert(errors * 100 > fragments * 9 and errors * 100 < fragments * 11);
+}
+
+} // namespace
+
+auto main() -> int
+{
+	test_determinism();
+	test_lengths();
+	test_errors();
+
+	return 0;
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
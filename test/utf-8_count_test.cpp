@@ -0,0 +1,87 @@
+#include "utf-8.h"
+#include "utf-8/corpus.h"
+
+#include <cassert>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+// Reference count, through the decoding view
+constexpr auto reference_count(std::u8string_view bytes) -> std::size_t
+{
+	return static_cast<std::size_t>(std::ranges::distance(bytes | utf8::views::decode));
+}
+
+void test_compile_time()
+{
+	static_assert(utf8::count_code_points(std::u8string_view{u8""}) == 0);
+	static_assert(utf8::count_code_points(std::u8string_view{u8"$£Иह€한𐍈"}) == 7);
+	static_assert(utf8::count_code_points(std::u8string_view{u8"\xf4\x8f\xbf\"\xe2\x82"}) == 3);
+	static_assert(utf8::count_code_points(std::u8string_view{u8"\xc0\xaf\xed\xa0\x80"}) == 5);
+}
+
+void test_kernels()
+{
+	std::mt19937 generator{};
+	utf8::corpus::options options{.lengths = {8, 1, 1, 1}};
+
+	for (const auto set : {utf8::detail::isa::scalar, utf8::detail::isa::sse42, utf8::detail::isa::avx2,
+			       utf8::detail::isa::avx512}) {
+		if (not utf8::detail::supports(set)) {
+			continue;
+		}
+		const auto &kernels = utf8::detail::kernels_for(set);
+
+		for (auto i = 0; i < 2000; ++i) {
+			options.seed = generator();
+			auto sequence = utf8::corpus::generate(options, generator() % 512);
+			if (i % 2 != 0 and not sequence.empty()) {
+				sequence.insert(generator() % sequence.size(),
+				                utf8::corpus::generate({.seed = generator(), .error_rate = 1}, 4));
+			}
+
+			// Whatever the kernels take, they take up to a character boundary and count right.
+			const auto result = kernels.count_code_points(std::u8string_view{sequence});
+			const auto prefix = std::u8string_view{sequence}.substr(0, result.consumed);
+			assert(result.produced == reference_count(prefix));
+			assert(utf8::validate(prefix));
+		}
+	}
+}
+
+void test_random()
+{
+	std::mt19937 generator{};
+	utf8::corpus::options options{.lengths = {8, 1, 1, 1}};
+
+	for (auto i = 0; i < 2000; ++i) {
+		options.seed = generator();
+		options.error_rate = i % 4 != 0 ? 0.0 : 0.25;
+		const auto sequence = utf8::corpus::generate(options, generator() % 1024);
+		assert(utf8::count_code_points(std::u8string_view{sequence}) == reference_count(sequence));
+
+		// Windows do not all start at the same offsets.
+		for (std::size_t offset = 1; offset < 4 and offset < sequence.size(); ++offset) {
+			const auto suffix = std::u8string_view{sequence}.substr(offset);
+			assert(utf8::count_code_points(suffix) == reference_count(suffix));
+		}
+	}
+}
+
+} // namespace
+
+auto main() -> int
+{
+	test_compile_time();
+	test_kernels();
+	test_random();
+
+	return 0;
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -1,6 +1,7 @@
 #include "utf-8/decoder.h"
 
 #include <cassert>
+#include <cstdint>
 
 // https://www.cl.cam.ac.uk/~mgk25/ucs/examples/UTF-8-test.txt, which we use a lot here, was written when UTF-8 had
 // support for characters of 5 and 6 bytes, which no longer is the case! Additionally, when 5 and 6-byte were supported,
@@ -15,6 +16,9 @@
 
 namespace {
 
+// The whole state of a decoder fits in one word.
+static_assert(sizeof(utf8::decoder) == sizeof(uint32_t));
+
 void test_normal()
 {
 	utf8::decoder decoder{};
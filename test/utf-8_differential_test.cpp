@@ -0,0 +1,498 @@
+// Differential test of every accelerated path against the reference FSM, utf8::decoder one byte at a time.
+//
+// Usage: utf-8_differential_test [-n ITERATIONS] [FILE...]
+//
+// Every input is decoded, validated and counted by the reference FSM, then by the SIMD kernels of every instruction
+// set the CPU supports, driven over the whole input as the library drives them, and by every public function, view,
+// stream and parallel path. The first divergence is reported, with the bytes around it, and aborts. Inputs are the
+// given files, or else random and adversarial buffers. Built with UTF_8_FUZZING and -fsanitize=fuzzer, this is a
+// libFuzzer target instead.
+
+#include "utf-8.h"
+#include "utf-8/corpus.h"
+#include "utf-8/detail/dispatch.h"
+#include "utf-8/parallel.h"
+#include "utf-8/streambuf.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+/// @brief What the reference FSM makes of an input
+struct reference {
+	std::u32string code_points;
+	std::u16string code_units;
+	std::u8string encoded; // Of the code points
+	std::size_t first_error{};
+	bool valid{};
+};
+
+auto make_reference(std::span<const char8_t> bytes) -> reference
+{
+	reference out{};
+	utf8::decoder decoder{};
+	for (const auto byte : bytes) {
+		if (const auto code = decoder.decode(byte)) {
+			out.code_points.push_back(static_cast<char32_t>(*code));
+			if (const auto extra = decoder.fetch()) {
+				out.code_points.push_back(static_cast<char32_t>(*extra));
+			}
+		}
+	}
+	if (const auto code = decoder.check_last_error()) {
+		out.code_points.push_back(static_cast<char32_t>(*code));
+	}
+
+	utf8::encoder encoder{};
+	for (const auto code : out.code_points) {
+		if (code > 0xffff) {
+			out.code_units.push_back(static_cast<char16_t>(0xd7c0 + (code >> 10)));
+			out.code_units.push_back(static_cast<char16_t>(0xdc00 | (code & 0x3ff)));
+		} else {
+			out.code_units.push_back(static_cast<char16_t>(code));
+		}
+		const auto encoded = encoder.encode(code);
+		out.encoded.append(encoded.begin(), encoded.end());
+	}
+
+	// The first maximal subpart in error starts the character the validator was in, or is the byte it rejects.
+	utf8::validator validator{};
+	std::size_t character{};
+	out.first_error = bytes.size();
+	for (std::size_t i = 0; i < bytes.size() and out.first_error == bytes.size(); ++i) {
+		if (not validator.check_last_error()) {
+			character = i;
+		}
+		if (not validator.validate(bytes[i])) {
+			out.first_error = character;
+		}
+	}
+	if (out.first_error == bytes.size() and validator.check_last_error()) {
+		out.first_error = character;
+	}
+	out.valid = out.first_error == bytes.size();
+
+	return out;
+}
+
+/// @brief Report a divergence, with the bytes of the input around an offset, and abort
+[[noreturn]] void diverge(std::string_view path, std::span<const char8_t> bytes, std::size_t offset,
+			  const std::string &detail)
+{
+	std::fprintf(stderr, "%.*s diverges from the reference FSM on an input of %zu bytes: %s\n",
+		     static_cast<int>(path.size()), path.data(), bytes.size(), detail.c_str());
+
+	const auto start = std::min(offset, bytes.size()) - std::min<std::size_t>(offset, 16);
+	const auto end = std::min(bytes.size(), start + 48);
+	std::fprintf(stderr, "bytes from offset %zu:", start);
+	for (auto i = start; i < end; ++i) {
+		std::fprintf(stderr, " %02x", static_cast<unsigned>(bytes[i]));
+	}
+	std::fprintf(stderr, "\n");
+	std::abort();
+}
+
+/// @brief Check that a value matches the reference one
+template <typename T>
+void expect(std::string_view path, std::span<const char8_t> bytes, const T &actual, const T &expected)
+{
+	if (actual != expected) {
+		diverge(path, bytes, 0,
+			"got " + std::to_string(actual) + " instead of " + std::to_string(expected));
+	}
+}
+
+/// @brief Check that a sequence of code units matches the reference one, and report where it does not
+template <typename Char>
+void expect_sequence(std::string_view path, std::span<const char8_t> bytes, std::basic_string_view<Char> actual,
+		     std::basic_string_view<Char> expected)
+{
+	if (actual == expected) {
+		return;
+	}
+
+	const auto [mismatch, _] = std::ranges::mismatch(actual, expected);
+	const auto index = static_cast<std::size_t>(mismatch - actual.begin());
+	const auto value = [&](std::basic_string_view<Char> units) {
+		if (index == units.size()) {
+			return std::string{"end"};
+		}
+		return std::to_string(static_cast<unsigned long>(units[index]));
+	};
+
+	// The offset of the first code unit which differs, in the input, is not known, but it is no further than
+	// the bytes of that many code units.
+	diverge(path, bytes, std::min(index, bytes.size()),
+		"code unit " + std::to_string(index) + " is " + value(actual) + " instead of " + value(expected) +
+		    ", " + std::to_string(actual.size()) + " code units instead of " + std::to_string(expected.size()));
+}
+
+/// @brief Drive a decoding kernel over a whole input, as utf8::detail::decode_into does
+///
+/// @param step The kernel, taking the rest of the input and the output
+///
+/// @return The code units produced
+template <typename Char, typename Step>
+auto drive(std::span<const char8_t> bytes, std::size_t window, Step step) -> std::basic_string<Char>
+{
+	std::basic_string<Char> out(bytes.size() + 1, Char{});
+	std::size_t consumed{};
+	std::size_t produced{};
+	std::size_t fallback_end{};
+	utf8::decoder decoder{};
+
+	const auto output = [&](unsigned long code) {
+		if constexpr (std::same_as<Char, char16_t>) {
+			produced += utf8::detail::encode_utf16(code, out.data() + produced);
+		} else {
+			out[produced++] = static_cast<Char>(code);
+		}
+	};
+
+	while (consumed < bytes.size()) {
+		if (consumed >= fallback_end and not decoder.check_last_error().has_value()) {
+			const auto result = step(bytes.subspan(consumed), out.data() + produced);
+			consumed += result.consumed;
+			produced += result.produced;
+			if (result.consumed != 0) {
+				continue;
+			}
+			fallback_end = consumed + window;
+		}
+		if (const auto code = decoder.decode(bytes[consumed++])) {
+			output(*code);
+			if (const auto extra = decoder.fetch()) {
+				output(*extra);
+			}
+		}
+	}
+	if (const auto code = decoder.check_last_error()) {
+		output(*code);
+	}
+
+	out.resize(produced);
+	return out;
+}
+
+/// @brief Check the kernels of an instruction set, against the reference and against the scalar kernels for encoding
+void check_kernels(utf8::detail::isa set, std::string_view name, std::span<const char8_t> bytes,
+		   const reference &expected)
+{
+	const auto &kernels = utf8::detail::kernels_for(set);
+	const auto &scalar = utf8::detail::kernels_for(utf8::detail::isa::scalar);
+	const auto path = [&](std::string_view function) {
+		return std::string{function} + "<" + std::string{name} + ">";
+	};
+
+	expect(path("validate"), bytes, kernels.validate(bytes), expected.valid);
+
+	const auto code_points = drive<char32_t>(bytes, kernels.window, [&](auto rest, char32_t *out) {
+		return kernels.to_utf32(rest, out);
+	});
+	expect_sequence<char32_t>(path("to_utf32"), bytes, code_points, expected.code_points);
+
+	const auto code_units = drive<char16_t>(bytes, kernels.window, [&](auto rest, char16_t *out) {
+		return kernels.to_utf16(rest, out);
+	});
+	expect_sequence<char16_t>(path("to_utf16"), bytes, code_units, expected.code_units);
+
+	// Counting is driven as decoding, into code points which are never written.
+	std::size_t count{};
+	const auto counted = drive<char32_t>(bytes, kernels.window, [&](auto rest, char32_t *) {
+		const auto result = kernels.count_code_points(rest);
+		count += result.produced;
+		return utf8::detail::transcode_result{result.consumed, 0};
+	});
+	expect(path("count_code_points"), bytes, count + counted.size(), expected.code_points.size());
+
+	// Encoding, of the reference code points, then of the input taken as UTF-32 and UTF-16, with any values, and
+	// into outputs of any room
+	std::u8string encoded(expected.encoded.size(), u8'\0');
+	const auto result = kernels.from_utf32(expected.code_points, encoded);
+	expect(path("from_utf32"), bytes, result.produced, expected.encoded.size());
+	expect_sequence<char8_t>(path("from_utf32"), bytes, encoded, expected.encoded);
+
+	std::vector<char32_t> utf32(bytes.size() / 4);
+	std::vector<char16_t> utf16(bytes.size() / 2);
+	std::memcpy(utf32.data(), bytes.data(), utf32.size() * sizeof(char32_t));
+	std::memcpy(utf16.data(), bytes.data(), utf16.size() * sizeof(char16_t));
+	expect(path("encoded_length"), bytes, kernels.encoded_length(utf32), scalar.encoded_length(utf32));
+
+	for (const auto room : {bytes.size() * 3, bytes.size() / 2, bytes.size() / 7}) {
+		std::u8string actual(room, u8'\0');
+		std::u8string reference_bytes(room, u8'\0');
+
+		const auto from32 = kernels.from_utf32(utf32, actual);
+		const auto reference32 = scalar.from_utf32(utf32, reference_bytes);
+		expect(path("from_utf32 consumed"), bytes, from32.consumed, reference32.consumed);
+		const std::u8string_view produced32{actual.data(), from32.produced};
+		expect_sequence<char8_t>(path("from_utf32"), bytes, produced32,
+					 std::u8string_view{reference_bytes}.substr(0, reference32.produced));
+
+		const auto from16 = kernels.from_utf16(utf16, actual);
+		const auto reference16 = scalar.from_utf16(utf16, reference_bytes);
+		expect(path("from_utf16 consumed"), bytes, from16.consumed, reference16.consumed);
+		const std::u8string_view produced16{actual.data(), from16.produced};
+		expect_sequence<char8_t>(path("from_utf16"), bytes, produced16,
+					 std::u8string_view{reference_bytes}.substr(0, reference16.produced));
+	}
+}
+
+/// @brief Split an input at random
+auto split(std::span<const char8_t> bytes, std::mt19937 &generator) -> std::vector<std::span<const char8_t>>
+{
+	std::vector<std::span<const char8_t>> pieces;
+	for (std::size_t offset = 0; offset < bytes.size();) {
+		const auto size = std::min<std::size_t>(generator() % 70, bytes.size() - offset);
+		pieces.push_back(bytes.subspan(offset, size));
+		offset += size;
+	}
+	return pieces;
+}
+
+/// @brief Check the public functions, views, streams and parallel paths
+void check_public(std::span<const char8_t> bytes, const reference &expected, std::mt19937 &generator)
+{
+	expect("validate", bytes, utf8::validate(bytes), expected.valid);
+	expect("find_first_error", bytes, utf8::find_first_error(bytes), expected.first_error);
+	expect("count_code_points", bytes, utf8::count_code_points(bytes), expected.code_points.size());
+	expect("utf16_length", bytes, utf8::utf16_length(bytes), expected.code_units.size());
+	expect("index", bytes, utf8::index{bytes, 1 + generator() % 64}.size(), expected.code_points.size());
+
+	std::u32string code_points(bytes.size(), U'\0');
+	code_points.resize(utf8::to_utf32(bytes, code_points));
+	expect_sequence<char32_t>("to_utf32", bytes, code_points, expected.code_points);
+
+	std::u16string code_units(bytes.size(), u'\0');
+	code_units.resize(utf8::to_utf16(bytes, code_units));
+	expect_sequence<char16_t>("to_utf16", bytes, code_units, expected.code_units);
+
+	std::u8string encoded(utf8::encoded_length(expected.code_points), u8'\0');
+	encoded.resize(utf8::from_utf32(expected.code_points, encoded));
+	expect_sequence<char8_t>("from_utf32", bytes, encoded, expected.encoded);
+	encoded.assign(expected.encoded.size(), u8'\0');
+	encoded.resize(utf8::from_utf16(expected.code_units, encoded));
+	expect_sequence<char8_t>("from_utf16", bytes, encoded, expected.encoded);
+
+	// Byte-wise decoders and views
+	std::u32string shifted;
+	utf8::shift_decoder shift_decoder{};
+	for (const auto byte : bytes) {
+		if (const auto code = shift_decoder.decode(byte)) {
+			shifted.push_back(static_cast<char32_t>(*code));
+			if (const auto extra = shift_decoder.fetch()) {
+				shifted.push_back(static_cast<char32_t>(*extra));
+			}
+		}
+	}
+	if (const auto code = shift_decoder.check_last_error()) {
+		shifted.push_back(static_cast<char32_t>(*code));
+	}
+	expect_sequence<char32_t>("shift_decoder", bytes, shifted, expected.code_points);
+
+	const std::u8string_view view{bytes.data(), bytes.size()};
+	std::u32string decoded;
+	for (const auto code : view | utf8::views::decode) {
+		decoded.push_back(static_cast<char32_t>(code));
+	}
+	expect_sequence<char32_t>("views::decode", bytes, decoded, expected.code_points);
+	decoded.clear();
+	for (const auto code : view | utf8::views::utf8_to_utf32) {
+		decoded.push_back(code);
+	}
+	expect_sequence<char32_t>("views::utf8_to_utf32", bytes, decoded, expected.code_points);
+	std::u16string transcoded;
+	for (const auto unit : view | utf8::views::utf8_to_utf16) {
+		transcoded.push_back(unit);
+	}
+	expect_sequence<char16_t>("views::utf8_to_utf16", bytes, transcoded, expected.code_units);
+
+	// Split inputs, as chunks of a stream and as segments
+	const auto pieces = split(bytes, generator);
+	utf8::stream_decoder stream_decoder{};
+	std::u32string streamed;
+	for (const auto piece : pieces) {
+		std::u32string out(utf8::stream_decoder::max_length(piece.size()), U'\0');
+		out.resize(stream_decoder.decode(piece, out).produced);
+		streamed += out;
+	}
+	if (const auto code = stream_decoder.finish()) {
+		streamed.push_back(static_cast<char32_t>(*code));
+	}
+	expect_sequence<char32_t>("stream_decoder", bytes, streamed, expected.code_points);
+
+	expect("validate(segments)", bytes, utf8::validate(utf8::segments{pieces}), expected.valid);
+	code_points.assign(bytes.size() + 1, U'\0');
+	code_points.resize(utf8::to_utf32(utf8::segments{pieces}, code_points));
+	expect_sequence<char32_t>("to_utf32(segments)", bytes, code_points, expected.code_points);
+	code_units.assign(bytes.size() + 1, u'\0');
+	code_units.resize(utf8::to_utf16(utf8::segments{pieces}, code_units));
+	expect_sequence<char16_t>("to_utf16(segments)", bytes, code_units, expected.code_units);
+
+	// Stream buffers, read in blocks since U+FFFF is the end of the stream one code unit at a time. Chunks of a
+	// single byte put every code point at the start of a chunk, U+FFFF included.
+	const auto chunk_size = 1 + generator() % 100;
+	std::stringbuf source;
+	for (const auto size : {std::size_t{1}, chunk_size}) {
+		source.str(std::string{bytes.begin(), bytes.end()});
+		utf8::decoding_streambuf<char16_t> decoding{source, size};
+		transcoded.assign(expected.code_units.size() + 1, u'\0');
+		transcoded.resize(static_cast<std::size_t>(
+		    decoding.sgetn(transcoded.data(), static_cast<std::streamsize>(transcoded.size()))));
+		expect_sequence<char16_t>("decoding_streambuf", bytes, transcoded, expected.code_units);
+	}
+
+	source.str(std::string{bytes.begin(), bytes.end()});
+	utf8::validating_streambuf validating{source, chunk_size};
+	while (validating.sbumpc() != std::char_traits<char>::eof()) {
+	}
+	expect("validating_streambuf", bytes, validating.first_error().value_or(bytes.size()), expected.first_error);
+
+	// Parallel paths, which only split inputs of several times utf8::detail::parallel_chunk_size
+	expect("parallel_validate", bytes, utf8::parallel_validate(bytes, 4), expected.valid);
+	expect("parallel_find_first_error", bytes, utf8::parallel_find_first_error(bytes, 4), expected.first_error);
+	expect("parallel_count_code_points", bytes, utf8::parallel_count_code_points(bytes, 4),
+	       expected.code_points.size());
+	code_points.assign(expected.code_points.size(), U'\0');
+	code_points.resize(utf8::parallel_to_utf32(bytes, code_points, 4));
+	expect_sequence<char32_t>("parallel_to_utf32", bytes, code_points, expected.code_points);
+}
+
+/// @brief Check every path on an input
+void check(std::span<const char8_t> bytes)
+{
+	static constexpr std::array sets{
+	    std::pair{utf8::detail::isa::scalar, "scalar"}, std::pair{utf8::detail::isa::sse42, "sse42"},
+	    std::pair{utf8::detail::isa::avx2, "avx2"}, std::pair{utf8::detail::isa::avx512, "avx512"}};
+
+	const auto expected = make_reference(bytes);
+	for (const auto &[set, name] : sets) {
+		if (utf8::detail::supports(set)) {
+			check_kernels(set, name, bytes, expected);
+		}
+	}
+
+	// Splits depend on the input only, so that a failure reproduces from the input alone.
+	std::uint32_t hash = 2166136261U;
+	for (const auto byte : bytes) {
+		hash = (hash ^ byte) * 16777619U;
+	}
+	std::mt19937 generator{hash};
+	check_public(bytes, expected, generator);
+}
+
+/// @brief Generate an adversarial input: errors and characters around the boundaries of SIMD blocks, from bytes which
+/// the FSM tells apart
+auto adversarial(std::mt19937 &generator) -> std::u8string
+{
+	static constexpr std::array<char8_t, 24> interesting{0x00, 0x41, 0x7f, 0x80, 0x8f, 0x90, 0x9f, 0xa0,
+							     0xbf, 0xc0, 0xc1, 0xc2, 0xdf, 0xe0, 0xe1, 0xec,
+							     0xed, 0xee, 0xef, 0xf0, 0xf1, 0xf4, 0xf5, 0xff};
+	static constexpr std::array<std::u8string_view, 14> fragments{
+	    u8"é", u8"€", u8"🦊", u8"\U0010ffff", u8"\xe2\x82", u8"\xf0\x9f\xa6", u8"\xc0\xaf", u8"\xe0\x80\xaf",
+	    u8"\xed\xa0\x80", u8"\xf4\x90\x80\x80", u8"\xef\xbf\xbd", u8"\xef\xbf\xbe", u8"\xef\xbf\xbf", u8"\x80\x80"};
+
+	std::u8string bytes;
+	const auto pieces = 1 + generator() % 8;
+	for (std::size_t i = 0; i < pieces; ++i) {
+		switch (generator() % 3) {
+		case 0: {
+			// ASCII up to around a block boundary, then a fragment straddling it
+			const auto block = std::size_t{16} << (generator() % 3);
+			const auto padding = block - bytes.size() % block;
+			bytes.append(padding + block - generator() % 4, u8'a');
+			bytes += fragments.at(generator() % fragments.size());
+			break;
+		}
+		case 1:
+			for (auto count = generator() % 40; count > 0; --count) {
+				bytes.push_back(interesting.at(generator() % interesting.size()));
+			}
+			break;
+		default: {
+			const auto weight = [&] { return static_cast<unsigned>(generator() % 4); };
+			bytes += utf8::corpus::generate({.seed = generator(),
+							 .lengths = {weight(), weight(), weight(), weight()},
+							 .error_rate = static_cast<double>(generator() % 4) / 10},
+							generator() % 200);
+			break;
+		}
+		}
+	}
+	return bytes;
+}
+
+} // namespace
+
+#if defined(UTF_8_FUZZING)
+
+extern "C" auto LLVMFuzzerTestOneInput(const std::uint8_t *data, std::size_t size) -> int
+{
+	// Bytes may be read as char8_t, which has the same representation.
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	check({reinterpret_cast<const char8_t *>(data), size});
+	return 0;
+}
+
+#else
+
+auto main(int argc, char *argv[]) -> int
+{
+	const std::vector<std::string> args(argv + 1, argv + argc);
+	std::size_t iterations = 2000;
+	std::vector<std::string> files;
+	for (std::size_t i = 0; i < args.size(); ++i) {
+		if (args[i] == "-n" and i + 1 < args.size()) {
+			iterations = std::stoul(args[++i]);
+		} else {
+			files.push_back(args[i]);
+		}
+	}
+
+	// Replay given inputs, e.g. crashes found by the fuzzer
+	for (const auto &file : files) {
+		std::ifstream input{file, std::ios::binary};
+		if (not input) {
+			std::fprintf(stderr, "%s: cannot open\n", file.c_str());
+			return 2;
+		}
+		const std::string bytes{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+		check(std::u8string{bytes.begin(), bytes.end()});
+	}
+	if (not files.empty()) {
+		return 0;
+	}
+
+	std::mt19937 generator{};
+	for (std::size_t i = 0; i < iterations; ++i) {
+		check(adversarial(generator));
+	}
+
+	// Corpora with errors, large enough to be split by the parallel paths
+	static constexpr auto large = 3 * utf8::detail::parallel_chunk_size + 7;
+	for (const auto rate : {0.0, 0.001}) {
+		check(utf8::corpus::generate({.seed = 1, .error_rate = rate}, large));
+	}
+
+	return 0;
+}
+
+#endif
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,218 @@
+#include "utf-8.h"
+#include "utf-8/detail/dispatch.h"
+
+#include <array>
+#include <cassert>
+#include <random>
+#include <string>
+#include <string_view>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+// Reference encoding, one code point at a time
+constexpr auto reference_encode(std::u32string_view code_points) -> std::u8string
+{
+	std::u8string bytes;
+	utf8::encoder encoder{};
+
+	for (const auto code : code_points) {
+		const auto encoded = encoder.encode(code);
+		bytes.append(encoded.begin(), encoded.end());
+	}
+
+	return bytes;
+}
+
+// Reference transcoding of UTF-16, with unpaired surrogates replaced, one code point at a time
+constexpr auto reference_from_utf16(std::u16string_view code_units) -> std::u8string
+{
+	std::u32string code_points;
+
+	for (std::size_t i = 0; i < code_units.size(); ++i) {
+		const char32_t unit = code_units[i];
+		if (unit >= 0xd800 and unit < 0xdc00 and i + 1 < code_units.size() and code_units[i + 1] >= 0xdc00 and
+		    code_units[i + 1] < 0xe000) {
+			code_points.push_back(0x10000 + ((unit - 0xd800) << 10) + (code_units[++i] - 0xdc00));
+		} else {
+			code_points.push_back(unit >= 0xd800 and unit < 0xe000 ? 0xfffd : unit);
+		}
+	}
+
+	return reference_encode(code_points);
+}
+
+// Random code points of every length, with runs of ASCII and of code points below U+0800, and some values which are
+// not scalar values
+auto random_code_points(std::mt19937 &generator, std::size_t size) -> std::u32string
+{
+	static constexpr std::array<char32_t, 12> samples{U'a', U'é', U'€', U'🦊', 0x7f, 0x80, 0x7ff, 0x800,
+							  0xffff, 0x10000, 0x10ffff, 0xfffd};
+	static constexpr std::array<char32_t, 4> invalid{0xd800, 0xdfff, 0x110000, 0xffffffff};
+
+	std::u32string code_points;
+	while (code_points.size() < size) {
+		switch (generator() % 8) {
+		case 0:
+			code_points.append(generator() % 64, U'x');
+			break;
+		case 1:
+			code_points.push_back(invalid.at(generator() % invalid.size()));
+			break;
+		case 2:
+			code_points.push_back(static_cast<char32_t>(generator() % 0x110000));
+			break;
+		case 3:
+			for (auto count = generator() % 64; count > 0; --count) {
+				code_points.push_back(static_cast<char32_t>(generator() % 0x800));
+			}
+			break;
+		default:
+			code_points.push_back(samples.at(generator() % samples.size()));
+			break;
+		}
+	}
+
+	return code_points;
+}
+
+// Random UTF-16 sequences, with runs of ASCII and of code units below U+0800, surrogate pairs and unpaired surrogates
+auto random_code_units(std::mt19937 &generator, std::size_t size) -> std::u16string
+{
+	static constexpr std::array<std::u16string_view, 10> fragments{
+	    u"a", u"é", u"€", u"🦊", u"\U0010ffff", u"\ufffd", u"\xd83e", u"\xdd8a", u"\xdd8a\xd83e", u"\xd83e\xd83e"};
+
+	std::u16string code_units;
+	while (code_units.size() < size) {
+		switch (generator() % 8) {
+		case 0:
+			code_units.append(generator() % 64, u'x');
+			break;
+		case 1:
+			for (auto count = generator() % 64; count > 0; --count) {
+				code_units.push_back(static_cast<char16_t>(generator() % 0x800));
+			}
+			break;
+		case 2:
+			code_units.push_back(static_cast<char16_t>(generator()));
+			break;
+		default:
+			code_units += fragments.at(generator() % fragments.size());
+			break;
+		}
+	}
+
+	return code_units;
+}
+
+void test_compile_time()
+{
+	static_assert(utf8::encoded_length(std::u32string_view{U"$£Иह€한𐍈"}) == 18);
+	static_assert(utf8::encoded_length(std::u32string_view{U"\xd800\x110000"}) == 6);
+	static_assert([] {
+		std::array<char8_t, 18> bytes{};
+		return utf8::from_utf32(std::u32string_view{U"$£Иह€한𐍈"}, bytes) == bytes.size() and
+		       std::u8string_view{bytes.data(), bytes.size()} == u8"$£Иह€한𐍈";
+	}());
+	static_assert([] {
+		std::array<char8_t, 13> bytes{};
+		return utf8::from_utf16(std::u16string_view{u"\xd83e🦊\xdd8a\xd83e"}, bytes) == bytes.size() and
+		       std::u8string_view{bytes.data(), bytes.size()} == u8"�🦊��";
+	}());
+}
+
+void test_kernels()
+{
+	std::mt19937 generator{};
+
+	for (const auto set : {utf8::detail::isa::scalar, utf8::detail::isa::sse42, utf8::detail::isa::avx2,
+			       utf8::detail::isa::avx512}) {
+		if (not utf8::detail::supports(set)) {
+			continue;
+		}
+		const auto &kernels = utf8::detail::kernels_for(set);
+
+		for (auto i = 0; i < 2000; ++i) {
+			const auto code_points = random_code_points(generator, generator() % 256);
+			const auto expected = reference_encode(code_points);
+			assert(kernels.encoded_length(code_points) == expected.size());
+
+			std::u8string out(expected.size(), u8'\0');
+			const auto result = kernels.from_utf32(code_points, out);
+			assert(result.consumed == code_points.size() and result.produced == expected.size());
+			assert(out == expected);
+
+			// With a shorter output, the kernels stop at a code point which does not fit, and not before.
+			const auto size = generator() % (expected.size() + 1);
+			std::u8string shorter(size, u8'\0');
+			const auto partial = kernels.from_utf32(code_points, shorter);
+			const auto encoded =
+			    reference_encode(std::u32string_view{code_points}.substr(0, partial.consumed));
+			assert(partial.produced == encoded.size() and shorter.substr(0, partial.produced) == encoded);
+			assert(partial.consumed == code_points.size() or
+			       encoded.size() + utf8::encoder::length(code_points[partial.consumed]) > size);
+		}
+
+		for (auto i = 0; i < 2000; ++i) {
+			const auto code_units = random_code_units(generator, generator() % 256);
+			const auto expected = reference_from_utf16(code_units);
+
+			std::u8string out(3 * code_units.size(), u8'\0');
+			const auto result = kernels.from_utf16(code_units, out);
+			assert(result.consumed == code_units.size() and result.produced == expected.size());
+			assert(out.substr(0, result.produced) == expected);
+
+			// With a shorter output, the kernels stop at a character boundary, without splitting pairs.
+			std::u8string shorter(generator() % (expected.size() + 1), u8'\0');
+			const auto partial = kernels.from_utf16(code_units, shorter);
+			const auto prefix = std::u16string_view{code_units}.substr(0, partial.consumed);
+			assert(shorter.substr(0, partial.produced) == reference_from_utf16(prefix));
+			assert(expected.starts_with(reference_from_utf16(prefix)));
+		}
+	}
+}
+
+void test_from_utf32()
+{
+	std::mt19937 generator{};
+
+	for (auto i = 0; i < 1000; ++i) {
+		const auto code_points = random_code_points(generator, generator() % 1024);
+		const auto expected = reference_encode(code_points);
+		assert(utf8::encoded_length(code_points) == expected.size());
+
+		std::u8string out(4 * code_points.size(), u8'\0');
+		out.resize(utf8::from_utf32(code_points, out));
+		assert(out == expected);
+	}
+}
+
+void test_from_utf16()
+{
+	std::mt19937 generator{};
+
+	for (auto i = 0; i < 1000; ++i) {
+		const auto code_units = random_code_units(generator, generator() % 1024);
+		const auto expected = reference_from_utf16(code_units);
+
+		std::u8string out(3 * code_units.size(), u8'\0');
+		out.resize(utf8::from_utf16(code_units, out));
+		assert(out == expected);
+		assert(std::ranges::equal(code_units | utf8::views::from_utf16, expected));
+	}
+}
+
+} // namespace
+
+auto main() -> int
+{
+	test_compile_time();
+	test_kernels();
+	test_from_utf32();
+	test_from_utf16();
+
+	return 0;
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,85 @@
+#include "utf-8/decoder.h"
+#include "utf-8/encoder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <span>
+#include <string_view>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+constexpr auto encodes_to(unsigned long code, std::u8string_view expected) -> bool
+{
+	utf8::encoder encoder{};
+	return std::ranges::equal(encoder.encode(code), expected) and utf8::encoder::length(code) == expected.size();
+}
+
+void test_normal()
+{
+	// Characters of various lengths from Wikipedia, and the boundaries of every length
+
+	static_assert(encodes_to(0x24, u8"$"));
+	static_assert(encodes_to(0xa3, u8"£"));
+	static_assert(encodes_to(0x418, u8"И"));
+	static_assert(encodes_to(0x939, u8"ह"));
+	static_assert(encodes_to(0x20ac, u8"€"));
+	static_assert(encodes_to(0xd55c, u8"한"));
+	static_assert(encodes_to(0x10348, u8"𐍈"));
+
+	static_assert(encodes_to(0x0, std::u8string_view{u8"\0", 1}));
+	static_assert(encodes_to(0x7f, u8"\x7f"));
+	static_assert(encodes_to(0x80, u8"\xc2\x80"));
+	static_assert(encodes_to(0x7ff, u8"\xdf\xbf"));
+	static_assert(encodes_to(0x800, u8"\xe0\xa0\x80"));
+	static_assert(encodes_to(0xd7ff, u8"\xed\x9f\xbf"));
+	static_assert(encodes_to(0xe000, u8"\xee\x80\x80"));
+	static_assert(encodes_to(0xffff, u8"\xef\xbf\xbf"));
+	static_assert(encodes_to(0x10000, u8"\xf0\x90\x80\x80"));
+	static_assert(encodes_to(0x10ffff, u8"\xf4\x8f\xbf\xbf"));
+}
+
+void test_replacement()
+{
+	// Values which are not Unicode scalar values
+
+	static_assert(encodes_to(0xd800, u8"\xef\xbf\xbd"));
+	static_assert(encodes_to(0xdbff, u8"\xef\xbf\xbd"));
+	static_assert(encodes_to(0xdc00, u8"\xef\xbf\xbd"));
+	static_assert(encodes_to(0xdfff, u8"\xef\xbf\xbd"));
+	static_assert(encodes_to(0x110000, u8"\xef\xbf\xbd"));
+	static_assert(encodes_to(0xffffffff, u8"\xef\xbf\xbd"));
+}
+
+// Every value up to beyond the last code point decodes back to itself, or to U+FFFD
+void test_round_trip()
+{
+	utf8::encoder encoder{};
+
+	for (unsigned long code = 0; code <= 0x110010; ++code) {
+		const auto bytes = encoder.encode(code);
+		assert(bytes.size() == utf8::encoder::length(code));
+
+		utf8::decoder decoder{};
+		for (const auto byte : bytes.first(bytes.size() - 1)) {
+			assert(not decoder.decode(byte).has_value());
+		}
+		const auto is_scalar_value = code < 0xd800 or (code > 0xdfff and code <= 0x10ffff);
+		assert(decoder.decode(bytes.back()) == (is_scalar_value ? code : 0xfffd));
+		assert(not decoder.fetch().has_value());
+	}
+}
+
+} // namespace
+
+auto main() -> int
+{
+	test_normal();
+	test_replacement();
+	test_round_trip();
+
+	return 0;
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,121 @@
+#include "utf-8.h"
+#include "utf-8/corpus.h"
+
+#include <cassert>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+// The byte offsets of all code points, followed by the size of the sequence, as the decoder decodes them
+auto reference_offsets(std::u8string_view bytes) -> std::vector<std::size_t>
+{
+	std::vector<std::size_t> offsets;
+	utf8::decoder decoder{};
+	std::size_t start{}; // Of the character being decoded
+
+	for (std::size_t i = 0; i < bytes.size(); ++i) {
+		if (not decoder.check_last_error().has_value()) {
+			start = i;
+		}
+		if (decoder.decode(bytes[i]).has_value()) {
+			// The code point is for the character, or the subpart in error it interrupted. Any extra one,
+			// or any character in progress after the interruption, starts at the interrupting byte.
+			offsets.push_back(start);
+			if (decoder.fetch().has_value()) {
+				offsets.push_back(i);
+			}
+			start = i;
+		}
+	}
+	if (decoder.check_last_error().has_value()) {
+		offsets.push_back(start);
+	}
+	offsets.push_back(bytes.size());
+
+	return offsets;
+}
+
+// Check all queries against the reference
+void check(const utf8::index &index, std::u8string_view bytes)
+{
+	const auto offsets = reference_offsets(bytes);
+	assert(index.size() == offsets.size() - 1);
+	assert(index.size() == static_cast<std::size_t>(std::ranges::distance(bytes | utf8::views::decode)));
+
+	for (std::size_t code_point = 0; code_point < offsets.size(); ++code_point) {
+		assert(index.byte_offset(code_point) == offsets[code_point]);
+	}
+
+	std::size_t code_point{};
+	for (std::size_t byte = 0; byte <= bytes.size(); ++byte) {
+		if (code_point + 1 < offsets.size() and byte == offsets[code_point + 1]) {
+			++code_point;
+		}
+		assert(index.code_point_offset(byte) == code_point);
+	}
+}
+
+void test_compile_time()
+{
+	static_assert(utf8::index{std::u8string_view{u8""}}.size() == 0);
+	static_assert(utf8::index{std::u8string_view{u8"$£Иह€한𐍈"}, 2}.byte_offset(6) == 14);
+	static_assert(utf8::index{std::u8string_view{u8"$£Иह€한𐍈"}, 2}.code_point_offset(16) == 6);
+	static_assert(utf8::index{std::u8string_view{u8"\xf4\x8f\xbf\"\xe2\x82"}, 1}.byte_offset(2) == 4);
+}
+
+void test_random()
+{
+	std::mt19937 generator{};
+	utf8::corpus::options options{.lengths = {8, 1, 1, 1}, .error_rate = 0.25};
+
+	for (auto i = 0; i < 300; ++i) {
+		options.seed = generator();
+		const auto sequence = utf8::corpus::generate(options, generator() % 512);
+		for (const std::size_t spacing : {1, 3, 16, 64, 1024}) {
+			check(utf8::index{std::u8string_view{sequence}, spacing}, sequence);
+		}
+	}
+}
+
+void test_update()
+{
+	std::mt19937 generator{};
+	utf8::corpus::options options{.lengths = {8, 1, 1, 1}, .error_rate = 0.25};
+
+	for (auto i = 0; i < 100; ++i) {
+		options.seed = generator();
+		auto sequence = utf8::corpus::generate(options, generator() % 512);
+		utf8::index index{std::u8string_view{sequence}, 1 + generator() % 32};
+
+		// Edits in the middle of characters, and right before continuation bytes, change characters around
+		// them.
+		for (auto edit = 0; edit < 20; ++edit) {
+			const auto offset = sequence.empty() ? 0 : generator() % sequence.size();
+			const auto removed = std::min<std::size_t>(generator() % 8, sequence.size() - offset);
+			options.seed = generator();
+			const auto inserted = utf8::corpus::generate(options, 8).substr(0, generator() % 8);
+
+			sequence.replace(offset, removed, inserted);
+			index.update(std::u8string_view{sequence}, offset, removed, inserted.size());
+			check(index, sequence);
+		}
+	}
+}
+
+} // namespace
+
+auto main() -> int
+{
+	test_compile_time();
+	test_random();
+	test_update();
+
+	return 0;
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,138 @@
+#include "utf-8/corpus.h"
+#include "utf-8/parallel.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+// Large sequences of valid characters, of one to four bytes
+auto large_sequence(std::uint64_t seed, std::size_t size) -> std::u8string
+{
+	return utf8::corpus::generate({.seed = seed}, size);
+}
+
+void test_split()
+{
+	const auto sequence = large_sequence(1, 5 * utf8::detail::parallel_chunk_size + 12345);
+	const std::span<const char8_t> bytes{sequence};
+
+	// Small sequences are not split.
+	assert(utf8::detail::split_at_units(bytes.first(1000), 8).size() == 1);
+	assert(utf8::detail::split_at_units(std::span<const char8_t>{}, 8).size() == 1);
+
+	for (const std::size_t threads : {0, 1, 2, 3, 5, 64}) {
+		const auto chunks = utf8::detail::split_at_units(bytes, threads);
+		assert(not chunks.empty() and chunks.size() <= 5);
+
+		// Chunks are contiguous, cover the whole sequence, and start at unit boundaries.
+		const auto *next = bytes.data();
+		for (const auto chunk : chunks) {
+			assert(chunk.data() == next and not chunk.empty());
+			const auto start = static_cast<std::size_t>(chunk.data() - bytes.data());
+			assert(utf8::detail::is_unit_boundary(bytes, start));
+			next += chunk.size();
+		}
+		assert(next == bytes.data() + bytes.size());
+	}
+}
+
+void test_errors()
+{
+	const auto sequence = large_sequence(2, 8 * utf8::detail::parallel_chunk_size);
+
+	assert(utf8::parallel_validate(sequence, 8));
+	assert(utf8::parallel_find_first_error(sequence, 8) == sequence.size());
+	assert(utf8::parallel_count_code_points(sequence, 8) == utf8::count_code_points(sequence));
+
+	// Errors around the split points, including characters interrupted or truncated there
+	const auto chunks = utf8::detail::split_at_units(sequence, 8);
+	for (std::size_t i = 1; i < chunks.size(); ++i) {
+		const auto split = static_cast<std::size_t>(chunks[i].data() - chunks[0].data());
+
+		for (const std::u8string_view error : {u8"\x80", u8"\xc3", u8"\xe2\x82", u8"\xf0\x9f\xa6", u8"\xff"}) {
+			for (auto offset = split - 4; offset <= split + 4; ++offset) {
+				auto bytes = sequence;
+				bytes.insert(offset, error);
+
+				assert(not utf8::parallel_validate(bytes, 8));
+				assert(utf8::parallel_find_first_error(bytes, 8) == utf8::find_first_error(bytes));
+				assert(utf8::parallel_count_code_points(bytes, 8) == utf8::count_code_points(bytes));
+			}
+		}
+	}
+
+	// Errors in several chunks: only the first one counts.
+	auto bytes = sequence;
+	bytes[bytes.size() - 10] = 0xff;
+	bytes[bytes.size() / 2] = 0xff;
+	bytes[bytes.size() / 3] = 0xc0;
+	assert(utf8::parallel_find_first_error(bytes) == utf8::find_first_error(bytes));
+	assert(utf8::parallel_find_first_error(bytes, 1) == utf8::find_first_error(bytes));
+	assert(utf8::parallel_count_code_points(bytes) == utf8::count_code_points(bytes));
+
+	// A truncated character at the very end
+	bytes = sequence + u8"\xf0\x9f";
+	assert(utf8::parallel_find_first_error(bytes, 8) == sequence.size());
+	assert(utf8::parallel_count_code_points(bytes, 8) == utf8::count_code_points(bytes));
+}
+
+// Check that a sequence is decoded in parallel exactly as it is sequentially
+auto decodes_like_to_utf32(std::u8string_view bytes, std::size_t threads) -> bool
+{
+	std::u32string expected(bytes.size(), U'\0');
+	expected.resize(utf8::to_utf32(bytes, expected));
+
+	// The output has exactly as much room as needed, followed by a guard that any write beyond it would change.
+	constexpr char32_t guard = 0xffffffff;
+	const auto count = utf8::parallel_count_code_points(bytes, threads);
+	std::u32string code_points(count + 1, guard);
+	const auto size = utf8::parallel_to_utf32(bytes, std::span{code_points}.first(count), threads);
+
+	return size == count and code_points.back() == guard and code_points.substr(0, count) == expected;
+}
+
+void test_to_utf32()
+{
+	const auto sequence = large_sequence(3, 4 * utf8::detail::parallel_chunk_size);
+
+	assert(decodes_like_to_utf32(u8"", 8));
+	assert(decodes_like_to_utf32(u8"$£Иह€한𐍈\xf0\x9f", 8));
+	for (const std::size_t threads : {1, 3, 4, 0}) {
+		assert(decodes_like_to_utf32(sequence, threads));
+	}
+
+	// Errors around the split points, including characters interrupted or truncated there
+	const auto chunks = utf8::detail::split_at_units(sequence, 4);
+	for (std::size_t i = 1; i < chunks.size(); ++i) {
+		const auto split = static_cast<std::size_t>(chunks[i].data() - chunks[0].data());
+
+		for (const std::u8string_view error : {u8"\x80", u8"\xc3", u8"\xe2\x82", u8"\xf0\x9f\xa6", u8"\xff"}) {
+			for (auto offset = split - 4; offset <= split + 4; ++offset) {
+				auto bytes = sequence;
+				bytes.insert(offset, error);
+				assert(decodes_like_to_utf32(bytes, 4));
+			}
+		}
+	}
+	assert(decodes_like_to_utf32(sequence + u8"\xe2\x82", 4));
+}
+
+} // namespace
+
+auto main() -> int
+{
+	test_split();
+	test_errors();
+	test_to_utf32();
+
+	return 0;
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "utf-8/decoder.h"
+
+#include <string>
+#include <string_view>
+
+// Reference decoding for the tests, by utf8::decoder one byte at a time, which every bulk path shall match.
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace utf8::test {
+
+// Reference decoding, one byte at a time
+constexpr auto reference_decode(std::u8string_view bytes) -> std::u32string
+{
+	std::u32string code_points;
+	utf8::decoder decoder{};
+
+	for (const auto byte : bytes) {
+		if (const auto code = decoder.decode(byte)) {
+			code_points.push_back(static_cast<char32_t>(*code));
+			if (const auto extra = decoder.fetch()) {
+				code_points.push_back(static_cast<char32_t>(*extra));
+			}
+		}
+	}
+	if (const auto code = decoder.check_last_error()) {
+		code_points.push_back(static_cast<char32_t>(*code));
+	}
+
+	return code_points;
+}
+
+// Reference transcoding into UTF-16, one code point at a time
+constexpr auto reference_utf16(std::u8string_view bytes) -> std::u16string
+{
+	std::u16string code_units;
+
+	for (const auto code : reference_decode(bytes)) {
+		if (code > 0xffff) {
+			code_units.push_back(static_cast<char16_t>(0xd800 + ((code - 0x10000) >> 10)));
+			code_units.push_back(static_cast<char16_t>(0xdc00 + (code & 0x3ff)));
+		} else {
+			code_units.push_back(static_cast<char16_t>(code));
+		}
+	}
+
+	return code_units;
+}
+
+} // namespace utf8::test
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
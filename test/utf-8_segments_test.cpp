@@ -0,0 +1,124 @@
+#include "utf-8/corpus.h"
+#include "utf-8/segments.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+// Segments of a sequence, split at the given offsets
+constexpr auto split(std::u8string_view bytes, std::span<const std::size_t> offsets)
+    -> std::vector<std::span<const char8_t>>
+{
+	std::vector<std::span<const char8_t>> segments;
+	std::size_t start{};
+
+	for (const auto offset : offsets) {
+		segments.emplace_back(bytes.substr(start, offset - start));
+		start = offset;
+	}
+	segments.emplace_back(bytes.substr(start));
+
+	return segments;
+}
+
+// Check that a sequence split at the given offsets is validated and decoded as a whole
+constexpr auto same_as_whole(std::u8string_view bytes, std::span<const std::size_t> offsets) -> bool
+{
+	const auto segments = split(bytes, offsets);
+
+	std::u32string whole(bytes.size(), U'\0');
+	std::u32string segmented(bytes.size(), U'\0');
+	whole.resize(utf8::to_utf32(bytes, whole));
+	segmented.resize(utf8::to_utf32(segments, segmented));
+
+	std::u16string whole16(bytes.size(), u'\0');
+	std::u16string segmented16(bytes.size(), u'\0');
+	whole16.resize(utf8::to_utf16(bytes, whole16));
+	segmented16.resize(utf8::to_utf16(segments, segmented16));
+
+	return utf8::validate(segments) == utf8::validate(bytes) and segmented == whole and segmented16 == whole16;
+}
+
+void test_compile_time()
+{
+	static constexpr std::array<std::size_t, 3> fox{1, 2, 3};
+	static constexpr std::array<std::size_t, 4> boundaries{0, 3, 3, 10};
+
+	static_assert(same_as_whole(u8"🦊", fox));
+	static_assert(same_as_whole(u8"\xf0\x9f\xa6\x8a", fox));
+	static_assert(same_as_whole(u8"\xf0\x9f\xa6\"", fox));
+	static_assert(same_as_whole(u8"$£Иह€한𐍈", boundaries));
+	static_assert(same_as_whole(u8"$£И\xe0\x80ह€한𐍈", boundaries));
+	static_assert(same_as_whole(u8"$£Иह€한𐍈\xe2\x82", boundaries));
+}
+
+void test_straddling()
+{
+	const std::u8string_view fox{u8"The quick brown 🦊 jumps"};
+
+	// The fox is split in every possible way, including with empty segments in the middle.
+	for (std::size_t first = 16; first <= 20; ++first) {
+		for (std::size_t second = first; second <= 20; ++second) {
+			const std::array offsets{first, second};
+			assert(same_as_whole(fox, offsets));
+			assert(utf8::validate(split(fox, offsets)));
+		}
+	}
+
+	// Segments which would be valid on their own do not make a valid sequence when they split a character.
+	const std::array<std::span<const char8_t>, 2> interrupted{std::u8string_view{u8"ab\xf0\x9f"},
+								   std::u8string_view{u8"cd"}};
+	assert(not utf8::validate(interrupted));
+
+	// Segments which would not be valid on their own make a valid sequence when they join a character.
+	const std::array<std::span<const char8_t>, 2> joined{std::u8string_view{u8"ab\xf0\x9f"},
+							      std::u8string_view{u8"\xa6\x8a"}};
+	assert(utf8::validate(joined));
+
+	const std::array<std::span<const char8_t>, 2> truncated{std::u8string_view{u8"ab"},
+								 std::u8string_view{u8"\xf0\x9f"}};
+	assert(not utf8::validate(truncated));
+	assert(utf8::validate(utf8::segments{}));
+}
+
+void test_random()
+{
+	std::mt19937 generator{};
+	utf8::corpus::options options{.lengths = {8, 1, 1, 1}};
+
+	for (auto i = 0; i < 2000; ++i) {
+		options.seed = generator();
+		options.error_rate = i % 2 == 0 ? 0.0 : 0.25;
+		const auto sequence = utf8::corpus::generate(options, generator() % 1024);
+
+		std::vector<std::size_t> offsets(generator() % 8);
+		for (auto &offset : offsets) {
+			offset = sequence.empty() ? 0 : generator() % sequence.size();
+		}
+		std::ranges::sort(offsets);
+
+		assert(same_as_whole(sequence, offsets));
+	}
+}
+
+} // namespace
+
+auto main() -> int
+{
+	test_compile_time();
+	test_straddling();
+	test_random();
+
+	return 0;
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,103 @@
+#include "utf-8/shift_decoder.h"
+
+#include <array>
+#include <cassert>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+// Decode a sequence with both decoders, checking that they agree at every step.
+template <std::size_t N>
+constexpr auto decode_both(const std::array<char8_t, N> &bytes) -> bool
+{
+	utf8::decoder decoder{};
+	utf8::shift_decoder shift_decoder{};
+
+	for (const auto byte : bytes) {
+		if (decoder.decode(byte) != shift_decoder.decode(byte) or decoder.fetch() != shift_decoder.fetch()) {
+			return false;
+		}
+	}
+
+	return decoder.check_last_error() == shift_decoder.check_last_error();
+}
+
+void test_compile_time()
+{
+	static_assert(decode_both(std::array<char8_t, 0>{}));
+	static_assert(decode_both(std::array<char8_t, 4>{0xf0, 0x90, 0x8d, 0x88}));
+	static_assert(decode_both(std::array<char8_t, 5>{0xf4, 0x8f, 0xbf, 0x22, 0xe2}));
+}
+
+void test_normal()
+{
+	utf8::shift_decoder decoder{};
+
+	assert(decoder.decode('a') == 97U);
+	assert(not decoder.fetch().has_value());
+	assert(not decoder.decode("£"[0]).has_value());
+	assert(decoder.decode("£"[1]) == 0xa3U);
+	assert(not decoder.decode("€"[0]).has_value());
+	assert(not decoder.decode("€"[1]).has_value());
+	assert(decoder.decode("€"[2]) == 0x20acU);
+	assert(not decoder.decode("𐍈"[0]).has_value());
+	assert(not decoder.decode("𐍈"[1]).has_value());
+	assert(not decoder.decode("𐍈"[2]).has_value());
+	assert(decoder.decode("𐍈"[3]) == 0x10348U);
+	assert(not decoder.fetch().has_value());
+	assert(not decoder.check_last_error().has_value());
+}
+
+void test_interruptions()
+{
+	utf8::shift_decoder decoder{};
+
+	assert(not decoder.decode(0xf4).has_value());
+	assert(not decoder.decode(0x8f).has_value());
+	assert(not decoder.decode(0xbf).has_value());
+	assert(decoder.decode('"') == 0xfffdU);
+	assert(decoder.fetch() == 0x22U);
+
+	assert(not decoder.decode(0xe0).has_value());
+	assert(decoder.decode(0x80) == 0xfffdU);
+	assert(decoder.fetch() == 0xfffdU);
+
+	assert(not decoder.decode(0xf4).has_value());
+	assert(decoder.decode("ह"[0]) == 0xfffdU);
+	assert(not decoder.fetch().has_value());
+	assert(not decoder.decode("ह"[1]).has_value());
+	assert(decoder.check_last_error() == 0xfffdU);
+	assert(decoder.decode("ह"[2]) == 0x939U);
+}
+
+// Every sequence of three bytes, and every sequence of four bytes starting with a valid four-byte start byte, which
+// covers every path through the FSM
+void test_exhaustive()
+{
+	for (unsigned int value = 0; value < 0x1000000; ++value) {
+		const std::array bytes{static_cast<char8_t>(value >> 16U), static_cast<char8_t>(value >> 8U),
+				       static_cast<char8_t>(value)};
+		assert(decode_both(bytes));
+	}
+
+	for (unsigned int value = 0xf0000000; value < 0xf5000000; ++value) {
+		const std::array bytes{static_cast<char8_t>(value >> 24U), static_cast<char8_t>(value >> 16U),
+				       static_cast<char8_t>(value >> 8U), static_cast<char8_t>(value)};
+		assert(decode_both(bytes));
+	}
+}
+
+} // namespace
+
+auto main() -> int
+{
+	test_compile_time();
+	test_normal();
+	test_interruptions();
+	test_exhaustive();
+
+	return 0;
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
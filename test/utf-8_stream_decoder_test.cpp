@@ -0,0 +1,174 @@
+#include "utf-8/corpus.h"
+#include "utf-8/stream_decoder.h"
+#include "utf-8_reference.h"
+
+#include <array>
+#include <cassert>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+using utf8::test::reference_decode;
+using utf8::test::reference_utf16;
+
+// Decoding with a stream decoder, in chunks of the given sizes in turn, into output buffers of the exact maximal length
+template <typename String>
+constexpr auto stream_decode(utf8::stream_decoder &decoder, std::u8string_view bytes,
+			     std::span<const std::size_t> chunk_sizes) -> String
+{
+	String out;
+
+	for (std::size_t i = 0; not bytes.empty(); ++i) {
+		const auto chunk = bytes.substr(0, chunk_sizes[i % chunk_sizes.size()]);
+		String buffer(utf8::stream_decoder::max_length(chunk.size()), {});
+		const auto [consumed, produced] = decoder.decode(chunk, buffer);
+		assert(consumed == chunk.size());
+		out.append(buffer, 0, produced);
+		bytes.remove_prefix(chunk.size());
+	}
+	if (const auto code = decoder.finish()) {
+		out.push_back(static_cast<typename String::value_type>(*code));
+	}
+
+	return out;
+}
+
+template <typename String>
+constexpr auto stream_decode(std::u8string_view bytes, std::size_t chunk_size) -> String
+{
+	utf8::stream_decoder decoder{};
+	const std::array sizes{chunk_size};
+
+	return stream_decode<String>(decoder, bytes, sizes);
+}
+
+void test_compile_time()
+{
+	static_assert(stream_decode<std::u32string>(u8"$£Иह€한𐍈", 1) == U"$£Иह€한𐍈");
+	static_assert(stream_decode<std::u32string>(u8"$£Иह€한𐍈", 3) == U"$£Иह€한𐍈");
+	static_assert(stream_decode<std::u32string>(u8"\xf4\x8f\xbf\"\xe2\x82", 1) == U"�\"�");
+	static_assert(stream_decode<std::u16string>(u8"$£Иह€한𐍈", 2) == u"$£Иह€한𐍈");
+	static_assert(stream_decode<std::u16string>(u8"\xf4\x8f\xbf\"\xe2\x82", 3) == u"�\"�");
+	static_assert(utf8::stream_decoder::max_length(0) == 1);
+}
+
+void test_straddling()
+{
+	utf8::stream_decoder decoder{};
+	std::array<char32_t, 4> out{};
+
+	// The fox straddles three chunks, and only appears with its last byte.
+	assert(decoder.decode(std::u8string_view{u8"a\xf0"}, out).produced == 1 and out[0] == U'a');
+	assert(decoder.pending());
+	assert(decoder.decode(std::u8string_view{u8"\x9f\xa6"}, out).produced == 0 and decoder.pending());
+	assert(decoder.decode(std::u8string_view{u8"\x8a"}, out).produced == 1 and out[0] == U'🦊');
+	assert(not decoder.pending() and not decoder.finish().has_value());
+
+	// An interrupted character and the interrupting byte take two code points out of a chunk of one byte.
+	assert(decoder.decode(std::u8string_view{u8"\xe2\x82"}, out).produced == 0);
+	const auto room = std::span{out}.first(utf8::stream_decoder::max_length(1));
+	assert(decoder.decode(std::u8string_view{u8"\""}, room).produced == 2);
+	assert(out[0] == U'�' and out[1] == U'"');
+
+	// A surrogate pair out of a chunk of one byte
+	std::array<char16_t, 2> units{};
+	assert(decoder.decode(std::u8string_view{u8"\xf0\x9f\xa6"}, units).produced == 0);
+	assert(decoder.decode(std::u8string_view{u8"\x8a"}, units).produced == 2);
+	assert(units[0] == 0xd83e and units[1] == 0xdd8a);
+
+	// Finishing concludes the sequence, and resets the decoder for the next one.
+	assert(decoder.decode(std::u8string_view{u8"\xf0\x9f"}, out).produced == 0);
+	assert(decoder.finish() == 0xfffd and not decoder.pending());
+	assert(not decoder.finish().has_value());
+	assert(decoder.decode(std::u8string_view{u8"\x8a"}, out).produced == 1 and out[0] == U'�');
+}
+
+// Decoding into outputs of a given size, smaller than the maximal length, resuming with the bytes left every time
+template <typename String>
+auto undersized_decode(std::u8string_view bytes, std::size_t room) -> String
+{
+	utf8::stream_decoder decoder{};
+	String out;
+	String buffer(room, {});
+
+	while (not bytes.empty()) {
+		const auto [consumed, produced] = decoder.decode(bytes, buffer);
+		assert(consumed != 0);
+		out.append(buffer, 0, produced);
+		bytes.remove_prefix(consumed);
+	}
+	if (const auto code = decoder.finish()) {
+		out.push_back(static_cast<typename String::value_type>(*code));
+	}
+
+	return out;
+}
+
+void test_undersized()
+{
+	// The bytes which do not fit are left for the next call, rather than lost.
+	utf8::stream_decoder decoder{};
+	std::array<char32_t, 2> out{};
+	const std::u8string_view bytes{u8"a\xe2\x82\""};
+	auto result = decoder.decode(bytes, out);
+	assert(result.consumed == 3 and result.produced == 1 and out[0] == U'a' and decoder.pending());
+	result = decoder.decode(bytes.substr(3), out);
+	assert(result.consumed == 1 and result.produced == 2 and out[0] == U'�' and out[1] == U'"');
+
+	// A surrogate pair is not split across outputs either, while the bytes before its last one are carried.
+	std::array<char16_t, 3> units{};
+	const std::u8string_view foxes{u8"🦊🦊"};
+	result = decoder.decode(foxes, units);
+	assert(result.consumed == 7 and result.produced == 2 and decoder.pending());
+	result = decoder.decode(foxes.substr(7), units);
+	assert(result.consumed == 1 and result.produced == 2 and units[0] == 0xd83e and units[1] == 0xdd8a);
+
+	std::mt19937 generator{};
+	utf8::corpus::options options{.lengths = {8, 1, 1, 1}, .error_rate = 0.25};
+	for (auto i = 0; i < 200; ++i) {
+		options.seed = generator();
+		const auto sequence = utf8::corpus::generate(options, generator() % 1024);
+		const auto room = 2 + generator() % 16;
+		assert(undersized_decode<std::u32string>(sequence, room) == reference_decode(sequence));
+		assert(undersized_decode<std::u16string>(sequence, room) == reference_utf16(sequence));
+	}
+}
+
+void test_random()
+{
+	std::mt19937 generator{};
+	utf8::corpus::options options{.lengths = {8, 1, 1, 1}, .error_rate = 0.25};
+	utf8::stream_decoder decoder{};
+
+	for (auto i = 0; i < 1000; ++i) {
+		options.seed = generator();
+		const auto sequence = utf8::corpus::generate(options, generator() % 1024);
+		std::array<std::size_t, 4> sizes{};
+		for (auto &size : sizes) {
+			size = 1 + generator() % 256;
+		}
+
+		// The same decoder is reused for every sequence.
+		assert(stream_decode<std::u32string>(decoder, sequence, sizes) == reference_decode(sequence));
+		assert(stream_decode<std::u16string>(decoder, sequence, sizes) == reference_utf16(sequence));
+	}
+}
+
+} // namespace
+
+auto main() -> int
+{
+	test_compile_time();
+	test_straddling();
+	test_undersized();
+	test_random();
+
+	return 0;
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,167 @@
+#include "utf-8/corpus.h"
+#include "utf-8/streambuf.h"
+
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <istream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+auto as_chars(std::u8string_view bytes) -> std::string
+{
+	return {bytes.begin(), bytes.end()};
+}
+
+// Decoding through a stream buffer, reading chunks of the given size
+template <typename Char>
+auto stream_decode(std::u8string_view bytes, std::size_t chunk_size) -> std::basic_string<Char>
+{
+	std::stringbuf source{as_chars(bytes)};
+	utf8::decoding_streambuf<Char> decoding{source, chunk_size};
+
+	return {std::istreambuf_iterator<Char>{&decoding}, std::istreambuf_iterator<Char>{}};
+}
+
+// Whole sequence decoding, for reference
+template <typename Char>
+auto decode(std::u8string_view bytes) -> std::basic_string<Char>
+{
+	std::basic_string<Char> out(bytes.size(), Char{});
+	if constexpr (std::same_as<Char, char16_t>) {
+		out.resize(utf8::to_utf16(bytes, out));
+	} else {
+		out.resize(utf8::to_utf32(bytes, out));
+	}
+	return out;
+}
+
+void test_decoding()
+{
+	const std::u8string_view text{u8"\xf0\x9f\xa6The quick brown fox jumps over the lazy dog, ça coûte 10€ 🦊\xe2"};
+
+	for (std::size_t chunk_size = 1; chunk_size <= text.size() + 1; ++chunk_size) {
+		assert(stream_decode<char32_t>(text, chunk_size) == decode<char32_t>(text));
+		assert(stream_decode<char16_t>(text, chunk_size) == decode<char16_t>(text));
+	}
+	assert(stream_decode<char32_t>(u8"", 16).empty());
+	assert(stream_decode<char32_t>(u8"\xf0\x9f", 16) == U"�");
+
+	std::mt19937 generator{};
+	utf8::corpus::options options{.lengths = {8, 1, 1, 1}, .error_rate = 0.25};
+	for (auto i = 0; i < 200; ++i) {
+		options.seed = generator();
+		const auto sequence = utf8::corpus::generate(options, generator() % 4096);
+		const auto chunk_size = 1 + generator() % 512;
+		assert(stream_decode<char32_t>(sequence, chunk_size) == decode<char32_t>(sequence));
+		assert(stream_decode<char16_t>(sequence, chunk_size) == decode<char16_t>(sequence));
+	}
+
+	// U+FFFF is the end of the stream for std::char_traits<char16_t>, but is kept when read in blocks, including
+	// at the start of a chunk.
+	for (const std::size_t chunk_size : {1, 2, 3, 4, 5, 16}) {
+		std::stringbuf source{as_chars(u8"\uffff\uffffa\uffff")};
+		utf8::decoding_streambuf<char16_t> decoding{source, chunk_size};
+		std::u16string code_units(8, u'\0');
+		code_units.resize(static_cast<std::size_t>(decoding.sgetn(code_units.data(), 8)));
+		assert(code_units == u"\uffff\uffffa\uffff");
+	}
+	std::stringbuf block_source{as_chars(u8"\uffff")};
+	utf8::decoding_streambuf<char16_t> block_decoding{block_source};
+	std::u16string code_units(2, u'\0');
+	assert(block_decoding.sgetn(code_units.data(), 2) == 1 and code_units.front() == u'\uffff');
+
+	// Read one code unit at a time, U+FFFF is whatever std::char_traits<char16_t>::to_int_type makes of it.
+	using traits = std::char_traits<char16_t>;
+	std::stringbuf unit_source{as_chars(u8"a\uffffb")};
+	utf8::decoding_streambuf<char16_t> unit_decoding{unit_source};
+	assert(unit_decoding.sbumpc() == u'a');
+	assert(unit_decoding.sbumpc() == traits::to_int_type(u'\uffff'));
+	assert(unit_decoding.sbumpc() == u'b' and unit_decoding.sbumpc() == traits::eof());
+#ifdef __GLIBCXX__
+	assert(traits::to_int_type(u'\uffff') == u'\ufffd');
+	assert(stream_decode<char16_t>(u8"a\uffffb", 16) == u"a\ufffdb");
+	std::stringbuf get_source{as_chars(u8"\uffff")};
+	utf8::decoding_streambuf<char16_t> get_decoding{get_source};
+	std::basic_istream<char16_t> get_stream{&get_decoding};
+	assert(get_stream.get() == u'\ufffd' and get_stream.get() == traits::eof());
+#endif
+
+	// Through a stream, with the default chunk size
+	options.seed = generator();
+	const auto large = utf8::corpus::generate(options, 300000);
+	std::stringbuf source{as_chars(large)};
+	utf8::decoding_streambuf decoding{source};
+	std::basic_istream<char32_t> stream{&decoding};
+	std::u32string code_points(large.size(), U'\0');
+	stream.read(code_points.data(), static_cast<std::streamsize>(code_points.size()));
+	code_points.resize(static_cast<std::size_t>(stream.gcount()));
+	assert(code_points == decode<char32_t>(large));
+}
+
+// Reading through a validating stream buffer, checking that bytes are passed unchanged
+auto stream_first_error(std::u8string_view bytes, std::size_t chunk_size) -> std::optional<std::size_t>
+{
+	std::stringbuf source{as_chars(bytes)};
+	utf8::validating_streambuf validating{source, chunk_size};
+	std::istream stream{&validating};
+
+	const std::string read{std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{}};
+	assert(read == as_chars(bytes));
+
+	return validating.first_error();
+}
+
+void test_validating()
+{
+	const std::u8string_view text{u8"The quick brown fox jumps over the lazy dog, ça coûte 10€ 🦊"};
+
+	for (std::size_t chunk_size = 1; chunk_size <= text.size() + 1; ++chunk_size) {
+		assert(not stream_first_error(text, chunk_size).has_value());
+
+		for (const std::u8string_view error : {u8"\x80", u8"\xe2\x82", u8"\xf0\x9f\xa6", u8"\xed\xa0\x80"}) {
+			for (const auto offset : {0, 20, 46, 56, 60}) {
+				std::u8string bytes{text};
+				bytes.insert(static_cast<std::size_t>(offset), error);
+				assert(stream_first_error(bytes, chunk_size) == utf8::find_first_error(bytes));
+			}
+		}
+	}
+
+	std::mt19937 generator{};
+	utf8::corpus::options options{.lengths = {8, 1, 1, 1}};
+	for (auto i = 0; i < 400; ++i) {
+		options.seed = generator();
+		options.error_rate = i % 2 == 0 ? 0.0 : 0.25;
+		const auto sequence = utf8::corpus::generate(options, generator() % 4096);
+		const auto error = utf8::find_first_error(sequence);
+		const auto expected = error == sequence.size() ? std::nullopt : std::optional{error};
+		assert(stream_first_error(sequence, 1 + generator() % 512) == expected);
+	}
+
+	// The error is known once the chunk holding it is read.
+	const auto bytes = as_chars(u8"abc\xff" u8"def");
+	std::stringbuf source{bytes};
+	utf8::validating_streambuf validating{source, 4};
+	assert(validating.sgetc() == 'a' and validating.first_error() == 3);
+}
+
+} // namespace
+
+auto main() -> int
+{
+	test_decoding();
+	test_validating();
+
+	return 0;
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -1,9 +1,168 @@
 #include "utf-8.h"
 
 #include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
 
 // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
 
+namespace {
+
+// The bytes of a text, as a range which can only be read once
+class input_only : public std::ranges::view_interface<input_only> {
+	std::u8string_view text_;
+
+public:
+	class iterator {
+		const char8_t *it_{};
+		const char8_t *end_{};
+
+	public:
+		using difference_type = std::ptrdiff_t;
+		using value_type = char8_t;
+
+		iterator() = default;
+		constexpr iterator(const char8_t *it, const char8_t *end) : it_{it}, end_{end} {}
+		constexpr auto operator*() const -> char8_t { return *it_; }
+		constexpr auto operator++() -> iterator &
+		{
+			++it_;
+			return *this;
+		}
+		constexpr void operator++(int) { ++it_; }
+		constexpr auto operator==(std::default_sentinel_t /*end*/) const -> bool { return it_ == end_; }
+	};
+
+	input_only() = default;
+	constexpr explicit input_only(std::u8string_view text) : text_{text} {}
+	[[nodiscard]] constexpr auto begin() const -> iterator { return {text_.data(), text_.data() + text_.size()}; }
+	[[nodiscard]] static constexpr auto end() -> std::default_sentinel_t { return {}; }
+};
+
+static_assert(std::ranges::input_range<utf8::decode_view<input_only>>);
+static_assert(not std::ranges::forward_range<utf8::decode_view<input_only>>);
+static_assert(std::ranges::bidirectional_range<utf8::decode_view<std::u8string_view>>);
+static_assert(std::ranges::common_range<utf8::decode_view<std::u8string_view>>);
+
+// Forward ranges are decoded unit by unit, forward and backward, while input ranges are decoded by the decoder.
+constexpr auto decodes_like_input_range(std::u8string_view text) -> bool
+{
+	std::vector<unsigned long> expected;
+	for (const auto code : input_only{text} | utf8::views::decode) {
+		expected.push_back(code);
+	}
+
+	return std::ranges::equal(text | utf8::views::decode, expected) and
+	       std::ranges::equal(text | utf8::views::decode | std::views::reverse, expected | std::views::reverse);
+}
+
+// Contiguous ranges take the ASCII fast path, while the same bytes seen through a transform view do not, including
+// when stepping back from the middle of an ASCII run.
+constexpr auto decodes_like_without_fast_path(std::u8string_view text) -> bool
+{
+	auto fast = text | utf8::views::decode;
+	auto slow = text | std::views::transform(std::identity{}) | utf8::views::decode;
+
+	if (not std::ranges::equal(fast, slow) or
+	    not std::ranges::equal(fast | std::views::reverse, slow | std::views::reverse)) {
+		return false;
+	}
+
+	// Two steps back, and forth again, from every code point
+	auto expected = slow.begin();
+	for (auto it = fast.begin(); it != fast.end(); ++it, ++expected) {
+		auto steps = 0;
+		for (; steps < 2 and it != fast.begin(); ++steps) {
+			--it;
+			--expected;
+		}
+		for (; steps > 0; --steps) {
+			if (*it++ != *expected++) {
+				return false;
+			}
+		}
+		if (*it != *expected) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Every sequence of up to four bytes, of values which cover every case of the decoder
+void test_short_sequences()
+{
+	static constexpr std::array<char8_t, 25> bytes{0x00, 0x41, 0x7f, 0x80, 0x8f, 0x90, 0x9f, 0xa0, 0xbf,
+						       0xc0, 0xc1, 0xc2, 0xdf, 0xe0, 0xe1, 0xec, 0xed, 0xee,
+						       0xef, 0xf0, 0xf1, 0xf3, 0xf4, 0xf5, 0xff};
+
+	std::array<char8_t, 4> text{};
+	for (std::size_t length = 1; length <= text.size(); ++length) {
+		auto combinations = std::size_t{1};
+		for (std::size_t i = 0; i < length; ++i) {
+			combinations *= bytes.size();
+		}
+		for (std::size_t combination = 0; combination < combinations; ++combination) {
+			for (std::size_t i = 0, rest = combination; i < length; ++i, rest /= bytes.size()) {
+				text.at(i) = bytes.at(rest % bytes.size());
+			}
+			assert(decodes_like_input_range({text.data(), length}));
+		}
+	}
+}
+
+// The fused views transcode like views::decode, followed by views::to_utf16, over contiguous, other forward and input
+// ranges
+constexpr auto transcodes_like_views(std::u8string_view text) -> bool
+{
+	auto utf16 = text | utf8::views::decode | utf8::views::to_utf16;
+	auto utf32 = text | utf8::views::decode;
+	const auto copy = text | std::views::transform([](char8_t byte) { return byte; });
+
+	return std::ranges::equal(text | utf8::views::utf8_to_utf16, utf16) and
+	       std::ranges::equal(copy | utf8::views::utf8_to_utf16, utf16) and
+	       std::ranges::equal(input_only{text} | utf8::views::utf8_to_utf16, utf16) and
+	       std::ranges::equal(text | utf8::views::utf8_to_utf32, utf32) and
+	       std::ranges::equal(copy | utf8::views::utf8_to_utf32, utf32);
+}
+
+// Long enough texts for the bulk kernels, with errors in and across their windows
+void test_transcode_views()
+{
+	std::u8string text;
+	for (auto i = 0; i < 100; ++i) {
+		text += u8"The quick brown fox jumps over the lazy dog, ça coûte 10€ 🦊 ";
+		assert(transcodes_like_views(text));
+		text += i % 3 == 0 ? u8"\xf0\x9f" : i % 3 == 1 ? u8"\xed\xa0\x80" : u8"\xc0";
+		assert(transcodes_like_views(text));
+	}
+
+	// Passes over the same view are independent, however they interleave.
+	std::u16string expected;
+	for (const auto unit : text | utf8::views::decode | utf8::views::to_utf16) {
+		expected.push_back(unit);
+	}
+	auto view = std::u8string_view{text} | utf8::views::utf8_to_utf16;
+	auto first = view.begin();
+	std::size_t i = 0;
+	for (; i < 1000; ++i, ++first) {
+	}
+	auto second = view.begin();
+	for (std::size_t j = 0; i < expected.size(); ++i, ++j, ++first, ++second) {
+		assert(*first == expected[i] and *second == expected[j]);
+	}
+	assert(first == view.end());
+}
+
+} // namespace
+
 auto main() -> int
 {
 	static_assert(std::ranges::equal("$£Иह€한𐍈" | utf8::views::decode,
@@ -11,6 +170,73 @@ auto main() -> int
 						    0x0000d55c, 0x00010348, 0x00000000}));
 	static_assert(std::ranges::equal(std::array{char8_t{0x24}, char8_t{0xc2}} | utf8::views::decode,
 					 std::array{0x00000024, 0x0000fffd}));
+
+	static_assert(std::ranges::equal(std::u8string_view{u8"$£Иह€한𐍈"} | utf8::views::decode | utf8::views::to_utf16,
+					 std::u16string_view{u"$£Иह€한𐍈"}));
+	static_assert(std::ranges::equal(std::array{0x24UL, 0xd800UL, 0x110000UL, 0x1f98aUL} | utf8::views::to_utf16,
+					 std::u16string_view{u"$��🦊"}));
+
+	static_assert(std::ranges::equal(std::u8string_view{u8"$£Иह€한𐍈"} | utf8::views::decode | utf8::views::encode,
+					 std::u8string_view{u8"$£Иह€한𐍈"}));
+	static_assert(std::ranges::equal(std::u8string_view{u8"\xf0\x9f\xa6$\xed\xa0\x80"} | utf8::views::decode |
+					     utf8::views::encode,
+					 std::u8string_view{u8"\xef\xbf\xbd$\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd"}));
+	static_assert(std::ranges::equal(std::array{0x24UL, 0xd800UL, 0x110000UL, 0x1f98aUL} | utf8::views::encode,
+					 std::u8string_view{u8"$��🦊"}));
+
+	static_assert(std::ranges::equal(std::u16string_view{u"$£Иह€한𐍈"} | utf8::views::from_utf16,
+					 std::u8string_view{u8"$£Иह€한𐍈"}));
+	static_assert(std::ranges::equal(std::u16string_view{u"\xdd8a\xd83e$\xd83e\xd83e\xdd8a\xd83e"} |
+					     utf8::views::from_utf16,
+					 std::u8string_view{u8"��$�🦊�"}));
+	static_assert(std::ranges::equal(std::u8string_view{u8"$£Иह€한𐍈"} | utf8::views::decode | utf8::views::to_utf16 |
+					     utf8::views::from_utf16,
+					 std::u8string_view{u8"$£Иह€한𐍈"}));
+
+	static_assert(transcodes_like_views(u8""));
+	static_assert(transcodes_like_views(u8"$£Иह€한𐍈"));
+	static_assert(
+	    transcodes_like_views(u8"\xf0\x9f\xa6The quick brown fox jumps over the lazy dog, ça coûte 10€ 🦊\xe2"));
+	static_assert(transcodes_like_views(u8"\xf4\x8f\xbf\"interrupted\", then \xed\xa0\x80 surrogates\xf0\x9f"));
+	static_assert(std::ranges::equal("$£Иह€한𐍈" | utf8::views::utf8_to_utf16, std::u16string_view{u"$£Иह€한𐍈\0", 9}));
+
+	static_assert(decodes_like_input_range(u8""));
+	static_assert(decodes_like_input_range(u8"The quick brown fox jumps over the lazy dog, ça coûte 10€ 🦊"));
+	static_assert(decodes_like_input_range(u8"\xf0\x9f\xa6The quick brown fox jumps over the lazy dog\xe2"));
+	static_assert(decodes_like_input_range(u8"\xc2\x80\x80\x80The quick brown fox jumps over the lazy\xc0"));
+
+	static_assert(decodes_like_without_fast_path(u8""));
+	static_assert(decodes_like_without_fast_path(u8"The quick brown fox jumps over the lazy dog, ça coûte 10€ 🦊"));
+	static_assert(decodes_like_without_fast_path(u8"\xf0\x9f\xa6The quick brown fox jumps over the lazy dog\xe2"));
+	static_assert(decodes_like_without_fast_path(u8"\xc2\x80\x80\x80The quick brown fox jumps over the lazy\xc0"));
+
+	for (const auto text : {std::u8string_view{u8"The quick brown fox jumps over the lazy dog. Pack my box with "
+						   u8"five dozen liquor jugs. How vexingly quick daft zebras jump!"},
+				std::u8string_view{u8"ASCII, then \xf4\x8f\xbf\"interrupted\", then \xed\xa0\x80 "
+						   u8"surrogates, then a truncated sequence at the end\xf0\x9f"}}) {
+		for (std::size_t offset = 0; offset < text.size(); ++offset) {
+			assert(decodes_like_input_range(text.substr(offset)));
+			assert(decodes_like_without_fast_path(text.substr(offset)));
+		}
+	}
+
+	// Not all bidirectional ranges are random access, or common.
+	const auto text = std::u8string_view{u8"\xf0\x9f\xa6\x8a ça coûte 10€ \xe2\x82\x80\x80\xf0\x9f"};
+	const std::list<char8_t> list{text.begin(), text.end()};
+	assert(std::ranges::equal(list | utf8::views::decode | std::views::reverse,
+				  text | utf8::views::decode | std::views::reverse));
+	const auto counted = std::views::counted(list.begin(), static_cast<std::ptrdiff_t>(list.size()));
+	static_assert(not std::ranges::common_range<decltype(counted | utf8::views::decode)>);
+	assert(std::ranges::equal(counted | utf8::views::decode | std::views::reverse,
+				  text | utf8::views::decode | std::views::reverse));
+
+	test_short_sequences();
+
+	// The iterators allocate their bulk buffer, so they stay small, and cannot be copied.
+	using transcode_iterator = std::ranges::iterator_t<decltype(text | utf8::views::utf8_to_utf16)>;
+	static_assert(sizeof(transcode_iterator) < 64 and not std::copyable<transcode_iterator>);
+	test_transcode_views();
+
 	return 0;
 }
 
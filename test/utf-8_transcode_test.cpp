@@ -0,0 +1,232 @@
+#include "utf-8/corpus.h"
+#include "utf-8/detail/dispatch.h"
+#include "utf-8/transcode.h"
+#include "utf-8_reference.h"
+
+#include <array>
+#include <cassert>
+#include <random>
+#include <string>
+#include <string_view>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+using utf8::test::reference_decode;
+using utf8::test::reference_utf16;
+
+// Transcoding into UTF-16 in chunks of at most chunk_size bytes, into output buffers of out_size code units (at least
+// two)
+constexpr auto chunked_utf16(std::u8string_view bytes, std::size_t chunk_size, std::size_t out_size) -> std::u16string
+{
+	std::u16string code_units;
+	std::u16string buffer(out_size, u'\0');
+	utf8::decoder state{};
+
+	while (not bytes.empty()) {
+		const auto result = utf8::decode_into(bytes.substr(0, chunk_size), buffer, state);
+		assert(result.consumed > 0);
+		code_units.append(buffer, 0, result.produced);
+		bytes.remove_prefix(result.consumed);
+		state = result.state;
+	}
+	if (const auto code = state.check_last_error()) {
+		code_units.push_back(static_cast<char16_t>(*code));
+	}
+
+	return code_units;
+}
+
+// Decoding in chunks of at most chunk_size bytes, into output buffers of out_size code points (at least two)
+constexpr auto chunked_decode(std::u8string_view bytes, std::size_t chunk_size, std::size_t out_size) -> std::u32string
+{
+	std::u32string code_points;
+	std::u32string buffer(out_size, U'\0');
+	utf8::decoder state{};
+
+	while (not bytes.empty()) {
+		const auto chunk = bytes.substr(0, chunk_size);
+		const auto result = utf8::decode_into(chunk, buffer, state);
+		assert(result.consumed > 0);
+		code_points.append(buffer, 0, result.produced);
+		bytes.remove_prefix(result.consumed);
+		state = result.state;
+	}
+	if (const auto code = state.check_last_error()) {
+		code_points.push_back(static_cast<char32_t>(*code));
+	}
+
+	return code_points;
+}
+
+void test_compile_time()
+{
+	static_assert(chunked_decode(u8"$£Иह€한𐍈", 3, 2) == U"$£Иह€한𐍈");
+	static_assert(chunked_decode(u8"\xf4\x8f\xbf\"\xe2\x82", 2, 2) == U"�\"�");
+	static_assert(chunked_utf16(u8"$£Иह€한𐍈", 3, 2) == u"$£Иह€한𐍈");
+	static_assert(chunked_utf16(u8"\xf4\x8f\xbf\"\xe2\x82", 2, 2) == u"�\"�");
+	static_assert(utf8::utf16_length(std::u8string_view{u8"$£Иह€한𐍈"}) == 8);
+	static_assert(utf8::utf16_length(std::u8string_view{u8"\xf0\x9f\xa6\xf0\x9f\xa6\x8a"}) == 3);
+}
+
+void test_resumable()
+{
+	const auto text =
+	    std::u8string_view{u8"\xf0\x9f\xa6The quick brown fox jumps over the lazy dog, ça coûte 10€ 🦊\xe2"};
+	const auto expected = reference_decode(text);
+
+	for (std::size_t chunk_size = 1; chunk_size <= text.size(); ++chunk_size) {
+		for (std::size_t out_size = 2; out_size <= 4; ++out_size) {
+			assert(chunked_decode(text, chunk_size, out_size) == expected);
+		}
+		assert(chunked_decode(text, chunk_size, text.size()) == expected);
+	}
+}
+
+void test_output_full()
+{
+	std::array<char32_t, 1> buffer{};
+
+	// The interrupting quote would produce a second code point, which does not fit.
+	const auto first = utf8::decode_into(std::u8string_view{u8"\xf4\x8f\xbf\""}, buffer);
+	assert(first.consumed == 3 and first.produced == 0);
+
+	const auto second = utf8::decode_into(std::u8string_view{u8"\""}, buffer, first.state);
+	assert(second.consumed == 0 and second.produced == 0);
+
+	std::array<char32_t, 2> larger{};
+	const auto third = utf8::decode_into(std::u8string_view{u8"\""}, larger, first.state);
+	assert(third.consumed == 1 and third.produced == 2 and larger[0] == U'�' and larger[1] == U'"');
+}
+
+void test_random()
+{
+	std::mt19937 generator{};
+	utf8::corpus::options options{.lengths = {8, 1, 1, 1}, .error_rate = 0.25};
+
+	for (auto i = 0; i < 1000; ++i) {
+		options.seed = generator();
+		const auto sequence = utf8::corpus::generate(options, generator() % 256);
+		const auto expected = reference_decode(sequence);
+		assert(chunked_decode(sequence, sequence.size() + 1, sequence.size()) == expected);
+		assert(chunked_decode(sequence, 1 + generator() % 64, 2 + generator() % 64) == expected);
+	}
+}
+
+void test_kernels()
+{
+	std::mt19937 generator{};
+	utf8::corpus::options options{.lengths = {8, 1, 1, 1}};
+
+	for (const auto set : {utf8::detail::isa::scalar, utf8::detail::isa::sse42, utf8::detail::isa::avx2,
+			       utf8::detail::isa::avx512}) {
+		if (not utf8::detail::supports(set)) {
+			continue;
+		}
+		const auto &kernels = utf8::detail::kernels_for(set);
+
+		for (auto i = 0; i < 2000; ++i) {
+			// Mostly valid sequences, with an error every few windows
+			options.seed = generator();
+			auto sequence = utf8::corpus::generate(options, generator() % 512);
+			if (i % 2 != 0 and not sequence.empty()) {
+				sequence.insert(generator() % sequence.size(),
+				                utf8::corpus::generate({.seed = generator(), .error_rate = 1}, 4));
+			}
+
+			const auto prefix = [&](std::size_t size) {
+				return std::u8string_view{sequence}.substr(0, size);
+			};
+
+			// Whatever the kernels take, they take up to a character boundary and transcode right.
+			std::u32string out(sequence.size(), U'\0');
+			const auto result = kernels.to_utf32(std::u8string_view{sequence}, out.data());
+			assert(result.consumed <= sequence.size());
+			assert(out.substr(0, result.produced) == reference_decode(prefix(result.consumed)));
+
+			std::u16string out16(sequence.size(), u'\0');
+			const auto result16 = kernels.to_utf16(std::u8string_view{sequence}, out16.data());
+			assert(result16.consumed == result.consumed);
+			assert(out16.substr(0, result16.produced) == reference_utf16(prefix(result16.consumed)));
+
+			if (set != utf8::detail::isa::scalar and i % 2 == 0) {
+				assert(sequence.size() - result.consumed < utf8::detail::kernel_window + 16);
+			}
+		}
+	}
+}
+
+void test_to_utf32()
+{
+	std::mt19937 generator{};
+	utf8::corpus::options options{.lengths = {8, 1, 1, 1}};
+
+	for (auto i = 0; i < 1000; ++i) {
+		options.seed = generator();
+		options.error_rate = i % 4 != 0 ? 0.0 : 0.25;
+		const auto sequence = utf8::corpus::generate(options, generator() % 1024);
+		std::u32string out(sequence.size(), U'\0');
+		out.resize(utf8::to_utf32(std::u8string_view{sequence}, out));
+		assert(out == reference_decode(sequence));
+	}
+
+	std::array<char32_t, 3> buffer{};
+	assert(utf8::to_utf32(std::u8string_view{u8"\xf0\x9f\xa6"}, buffer) == 1 and buffer[0] == U'�');
+	assert(utf8::to_utf32(std::u8string_view{}, buffer) == 0);
+}
+
+void test_to_utf16()
+{
+	std::mt19937 generator{};
+	utf8::corpus::options options{.lengths = {8, 1, 1, 1}};
+
+	for (auto i = 0; i < 1000; ++i) {
+		options.seed = generator();
+		options.error_rate = i % 4 != 0 ? 0.0 : 0.25;
+		const auto sequence = utf8::corpus::generate(options, generator() % 1024);
+		const auto expected = reference_utf16(sequence);
+		assert(utf8::utf16_length(std::u8string_view{sequence}) == expected.size());
+
+		std::u16string out(sequence.size(), u'\0');
+		out.resize(utf8::to_utf16(std::u8string_view{sequence}, out));
+		assert(out == expected);
+
+		// An output of the exact length is enough, even though it is shorter than the input.
+		std::u16string exact(expected.size(), u'\0');
+		assert(utf8::to_utf16(std::u8string_view{sequence}, exact) == expected.size() and exact == expected);
+
+		assert(chunked_utf16(sequence, 1 + generator() % 64, 2 + generator() % 64) == expected);
+	}
+
+	// The length of sequences longer than the blocks counted at once, without errors and with a few
+	for (const auto error_rate : {0.0, 0.0001}) {
+		const auto sequence = utf8::corpus::generate({.seed = 5, .error_rate = error_rate}, 300000);
+		assert(utf8::utf16_length(std::u8string_view{sequence}) == reference_utf16(sequence).size());
+	}
+
+	// A surrogate pair does not fit in the last code unit of an output, so its last byte is left.
+	std::array<char16_t, 3> buffer{};
+	const auto first = utf8::decode_into(std::u8string_view{u8"ab🦊"}, buffer);
+	assert(first.consumed == 5 and first.produced == 2);
+
+	const auto second = utf8::decode_into(std::u8string_view{u8"\x8a"}, buffer, first.state);
+	assert(second.consumed == 1 and second.produced == 2 and buffer[0] == 0xd83e and buffer[1] == 0xdd8a);
+}
+
+} // namespace
+
+auto main() -> int
+{
+	test_compile_time();
+	test_resumable();
+	test_output_full();
+	test_random();
+	test_kernels();
+	test_to_utf32();
+	test_to_utf16();
+
+	return 0;
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,179 @@
+#include "utf-8/validate.h"
+#include "utf-8/validator.h"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+// Reference validation, through the decoder: a sequence is valid if and only if every replacement character it
+// decodes to was actually encoded in it.
+auto decoder_accepts(std::span<const char8_t> bytes) -> bool
+{
+	utf8::decoder decoder{};
+	std::size_t index{};
+
+	for (const auto byte : bytes) {
+		const auto code = decoder.decode(byte);
+		if (code == 0xfffdU and (decoder.fetch().has_value() or index < 2 or bytes[index - 2] != 0xef or
+					 bytes[index - 1] != 0xbf or byte != 0xbd)) {
+			return false;
+		}
+		++index;
+	}
+
+	return not decoder.check_last_error().has_value();
+}
+
+// All implementations of the bulk validation
+auto validate_all(std::span<const char8_t> bytes) -> bool
+{
+	const auto valid = utf8::detail::scalar::validate(bytes);
+
+	for (const auto set : {utf8::detail::isa::sse42, utf8::detail::isa::avx2, utf8::detail::isa::avx512}) {
+		if (utf8::detail::supports(set)) {
+			assert(utf8::detail::kernels_for(set).validate(bytes) == valid);
+		}
+	}
+	assert(utf8::validate(bytes) == valid);
+
+	return valid;
+}
+
+void test_validator()
+{
+	utf8::validator validator{};
+
+	assert(validator.validate('a'));
+	assert(validator.validate(0xe2));
+	assert(validator.validate(0x82));
+	assert(validator.check_last_error());
+	assert(validator.validate(0xac));
+	assert(not validator.check_last_error());
+
+	// Interruption by a start byte: validation restarts at the interrupting byte
+	assert(validator.validate(0xf0));
+	assert(not validator.validate(0xc3));
+	assert(validator.check_last_error());
+	assert(validator.validate(0xa9));
+	assert(not validator.check_last_error());
+
+	// Impossible bytes
+	assert(not validator.validate(0xc0));
+	assert(not validator.validate(0xff));
+	assert(not validator.check_last_error());
+}
+
+void test_compile_time()
+{
+	static_assert(utf8::validate(std::array<char8_t, 0>{}));
+	static_assert(utf8::validate(u8"$£Иह€한𐍈"));
+	static_assert(not utf8::validate(std::array{char8_t{0x24}, char8_t{0xc2}}));
+	static_assert(not utf8::validate(std::array{char8_t{0xed}, char8_t{0xa0}, char8_t{0x80}}));
+}
+
+// Every sequence of up to three bytes, after a given prefix
+void test_exhaustive_short_sequences(std::u8string_view prefix)
+{
+	std::vector<char8_t> buffer(prefix.begin(), prefix.end());
+	buffer.resize(prefix.size() + 3);
+
+	for (unsigned int value = 0; value < 0x1000000; ++value) {
+		buffer[prefix.size()] = static_cast<char8_t>(value >> 16U);
+		buffer[prefix.size() + 1] = static_cast<char8_t>(value >> 8U);
+		buffer[prefix.size() + 2] = static_cast<char8_t>(value);
+		assert(validate_all(buffer) == decoder_accepts(buffer));
+	}
+}
+
+// Every four-byte sequence starting with a four-byte start byte, crossing a block boundary
+void test_four_byte_sequences()
+{
+	std::vector<char8_t> buffer(64, u8'a');
+
+	for (unsigned int value = 0xf00000; value < 0x1000000; ++value) {
+		buffer[30] = static_cast<char8_t>(value >> 16U);
+		buffer[31] = static_cast<char8_t>(value >> 8U);
+		buffer[32] = static_cast<char8_t>(value);
+		for (const auto last : {char8_t{0x7f}, char8_t{0x80}, char8_t{0xbf}, char8_t{0xc0}}) {
+			buffer[33] = last;
+			assert(validate_all(buffer) == decoder_accepts(buffer));
+		}
+	}
+}
+
+void test_truncated_at_end()
+{
+	const auto text = std::u8string_view{u8"The quick brown fox jumps over the lazy dog, ça coûte 10€ 🦊"};
+
+	for (std::size_t size = 0; size <= text.size(); ++size) {
+		const auto bytes = std::span{text.data(), size};
+		assert(validate_all(bytes) == decoder_accepts(bytes));
+	}
+}
+
+// Reference offset of the first error: the longest valid prefix ends where the first maximal subpart in error starts.
+auto reference_first_error(std::span<const char8_t> bytes) -> std::size_t
+{
+	auto size = bytes.size();
+	while (not decoder_accepts(bytes.first(size))) {
+		--size;
+	}
+
+	return size;
+}
+
+void test_first_error()
+{
+	static_assert(utf8::find_first_error(std::array<char8_t, 0>{}) == 0);
+	static_assert(utf8::find_first_error(std::u8string_view{u8"$£Иह€한𐍈"}) == 18);
+	static_assert(utf8::find_first_error(std::u8string_view{u8"$£\xe0\x80"}) == 3);
+	static_assert(utf8::find_first_error(std::u8string_view{u8"$£\xe2\x82\""}) == 3);
+	static_assert(utf8::find_first_error(std::u8string_view{u8"$£\xf0\x9f\xa6"}) == 3);
+
+	const auto text = std::u8string_view{u8"The quick brown fox jumps over the lazy dog, ça coûte 10€ 🦊"};
+	for (const auto error : {u8"\x80", u8"\xc3", u8"\xe2\x82", u8"\xed\xa0\x80", u8"\xf0\x9f\xa6", u8"\xff"}) {
+		for (std::size_t offset = 0; offset <= text.size(); ++offset) {
+			std::u8string bytes{text};
+			bytes.insert(offset, error);
+			assert(utf8::find_first_error(bytes) == reference_first_error(bytes));
+		}
+	}
+
+	// Around and beyond the boundaries of the blocks validated at once, with characters straddling them
+	std::u8string large;
+	while (large.size() < 0x30000) {
+		large += text;
+	}
+	assert(utf8::find_first_error(large) == large.size());
+	for (const std::size_t offset : {0xffff, 0x10000, 0x10001, 0x2abcd}) {
+		auto bytes = large;
+		bytes[offset] = 0xff;
+		// Nothing after the impossible byte matters.
+		assert(utf8::find_first_error(bytes) == reference_first_error(std::span{bytes}.first(offset + 1)));
+	}
+}
+
+} // namespace
+
+auto main() -> int
+{
+	test_validator();
+	test_compile_time();
+	test_exhaustive_short_sequences(u8"");
+	test_exhaustive_short_sequences(u8"0123456789abcdef0123456789abcde"); // across block boundaries
+	test_exhaustive_short_sequences(u8"0123456789abcdef0123456789abcdé"); // after a multi-byte character
+	test_four_byte_sequences();
+	test_truncated_at_end();
+	test_first_error();
+
+	return 0;
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,208 @@
+// Generate a deterministic synthetic UTF-8 corpus, see utf-8/corpus.h.
+//
+// Usage: utf-8_generate [-s SEED] [-l W1,W2,W3,W4] [-e RATE] [-c W1,W2,W3,W4] SIZE [OUTPUT]
+//
+// - SIZE: the size of the corpus in bytes, with an optional K, M or G suffix for powers of 1024
+// - -s SEED: the seed of the random generator, 0 by default
+// - -l W1,W2,W3,W4: the relative weights of the characters of one to four bytes, 1,1,1,1 by default
+// - -e RATE: the probability that a fragment is an error rather than a character, 0 by default
+// - -c W1,W2,W3,W4: the relative weights of overlongs, surrogates, truncated characters and impossible bytes
+//
+// The corpus is written to OUTPUT if given, or to the standard output, and ends at a fragment boundary. The number of
+// characters and errors generated is printed to the standard error. The exit status is 2 on usage or I/O errors.
+
+#include "utf-8/corpus.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+auto parse_size(std::string_view text) -> std::optional<std::size_t>
+{
+	std::size_t shift{};
+	if (not text.empty()) {
+		switch (text.back()) {
+		case 'K':
+			shift = 10;
+			break;
+		case 'M':
+			shift = 20;
+			break;
+		case 'G':
+			shift = 30;
+			break;
+		default:
+			break;
+		}
+	}
+	if (shift != 0) {
+		text.remove_suffix(1);
+	}
+
+	std::size_t size{};
+	std::size_t parsed{};
+	try {
+		size = std::stoull(std::string{text}, &parsed);
+	} catch (const std::exception &) {
+		return std::nullopt;
+	}
+	if (parsed != text.size() or text.empty() or text.front() == '-') {
+		return std::nullopt;
+	}
+	return size << shift;
+}
+
+template <std::size_t N>
+auto parse_weights(std::string_view text) -> std::optional<std::array<unsigned, N>>
+{
+	std::array<unsigned, N> weights{};
+	for (std::size_t i = 0; i < N; ++i) {
+		const auto end = std::min(text.find(','), text.size());
+		const auto weight = parse_size(text.substr(0, end));
+		if (not weight.has_value() or *weight > std::numeric_limits<unsigned>::max() or
+		    (end == text.size()) != (i + 1 == N)) {
+			return std::nullopt;
+		}
+		weights.at(i) = static_cast<unsigned>(*weight);
+		text.remove_prefix(std::min(end + 1, text.size()));
+	}
+	return weights;
+}
+
+auto parse_rate(std::string_view text) -> std::optional<double>
+{
+	std::size_t parsed{};
+	double rate{};
+	try {
+		rate = std::stod(std::string{text}, &parsed);
+	} catch (const std::exception &) {
+		return std::nullopt;
+	}
+	if (parsed != text.size() or rate < 0 or rate > 1) {
+		return std::nullopt;
+	}
+	return rate;
+}
+
+/// @brief Parse the options, and return the size of the corpus and its output, if any
+auto parse(const std::vector<std::string> &args, utf8::corpus::options &options)
+    -> std::optional<std::pair<std::size_t, std::string>>
+{
+	std::vector<std::string_view> operands;
+
+	for (std::size_t i = 0; i < args.size(); ++i) {
+		const std::string_view arg = args[i];
+		if (arg.size() != 2 or arg.front() != '-') {
+			operands.push_back(arg);
+			continue;
+		}
+		if (++i == args.size()) {
+			return std::nullopt;
+		}
+
+		const std::string_view value = args[i];
+		auto valid = true;
+		switch (arg.back()) {
+		case 's': {
+			const auto seed = parse_size(value);
+			valid = seed.has_value() and value.find_first_not_of("0123456789") == std::string_view::npos;
+			options.seed = seed.value_or(0);
+			break;
+		}
+		case 'l': {
+			const auto lengths = parse_weights<4>(value);
+			valid = lengths.has_value();
+			options.lengths = lengths.value_or(options.lengths);
+			break;
+		}
+		case 'e': {
+			const auto rate = parse_rate(value);
+			valid = rate.has_value();
+			options.error_rate = rate.value_or(0);
+			break;
+		}
+		case 'c': {
+			const auto errors = parse_weights<utf8::corpus::error_categories>(value);
+			valid = errors.has_value();
+			options.errors = errors.value_or(options.errors);
+			break;
+		}
+		default:
+			valid = false;
+			break;
+		}
+		if (not valid) {
+			return std::nullopt;
+		}
+	}
+
+	const auto size = operands.empty() ? std::nullopt : parse_size(operands.front());
+	if (not size.has_value() or operands.size() > 2) {
+		return std::nullopt;
+	}
+	return std::pair{*size, operands.size() == 2 ? std::string{operands.back()} : std::string{}};
+}
+
+} // namespace
+
+auto main(int argc, char *argv[]) -> int
+{
+	static constexpr std::size_t chunk_size = 0x100000;
+
+	utf8::corpus::options options{};
+	const auto parsed = parse({argv + 1, argv + argc}, options);
+	if (not parsed.has_value()) {
+		std::cerr << "Usage: utf-8_generate [-s SEED] [-l W1,W2,W3,W4] [-e RATE] [-c W1,W2,W3,W4] SIZE "
+			     "[OUTPUT]\n";
+		return 2;
+	}
+	const auto &[size, path] = *parsed;
+
+	std::ofstream file;
+	if (not path.empty()) {
+		file.open(path, std::ios::binary);
+		if (not file) {
+			std::cerr << path << ": cannot open for writing\n";
+			return 2;
+		}
+	}
+	auto &output = path.empty() ? std::cout : file;
+
+	// Chunks are generated in a row, so the corpus does not depend on their size. A remainder shorter than a
+	// fragment is folded into the last chunk, which can then complete the fragment the chunk before left incomplete.
+	utf8::corpus::generator generator{options};
+	std::vector<char8_t> chunk(chunk_size + utf8::corpus::max_fragment_size);
+	for (std::size_t offset = 0; offset < size and output;) {
+		const auto rest = size - offset;
+		const auto bytes = std::span{chunk}.first(rest < chunk.size() ? rest : chunk_size);
+		generator.fill(bytes, bytes.size() == rest);
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		output.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		offset += bytes.size();
+	}
+
+	if (not output.flush()) {
+		std::cerr << "Cannot write the output\n";
+		return 2;
+	}
+
+	const auto &generated = generator.generated();
+	std::cerr << generated.characters << " characters, " << generated.errors[0] << " overlongs, "
+		  << generated.errors[1] << " surrogates, " << generated.errors[2] << " truncated characters, "
+		  << generated.errors[3] << " impossible bytes\n";
+
+	return 0;
+}
@@ -0,0 +1,218 @@
+// Validate, count or transcode UTF-8 files, mapped into memory, and report throughput.
+//
+// Usage: utf-8_tool validate|count|utf16|utf32 [-o OUTPUT] FILE...
+//
+// - validate: check every file, and print the offset of its first error, if any
+// - count: count the code points of every file, as decoded with replacement characters for errors
+// - utf16, utf32: transcode every file, in chunks, into OUTPUT if given (in native byte order), or nowhere
+//
+// Throughput only accounts for the processing of the mapped files, hence for reading them from the page cache or the
+// disk. The exit status is 1 if a file is not valid UTF-8 (validate only), 2 on usage or I/O errors, 0 otherwise.
+
+#include "utf-8.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace {
+
+/// @brief A file mapped into memory, read only, for sequential access
+class mapped_file {
+	std::span<const char8_t> bytes_;
+
+public:
+	explicit mapped_file(const std::string &path)
+	{
+		const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			throw std::system_error{errno, std::generic_category(), path};
+		}
+
+		struct stat status {};
+		void *data = nullptr;
+		auto error = 0;
+		if (::fstat(fd, &status) != 0) {
+			error = errno;
+		} else if (status.st_size > 0) {
+			data = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			error = data == MAP_FAILED ? errno : 0;
+		}
+		::close(fd); // The mapping holds its own reference to the file.
+
+		if (error != 0) {
+			throw std::system_error{error, std::generic_category(), path};
+		}
+		if (data != nullptr) {
+			const auto size = static_cast<std::size_t>(status.st_size);
+			::madvise(data, size, MADV_SEQUENTIAL); // Only a hint, so failure does not matter
+			bytes_ = {static_cast<const char8_t *>(data), size};
+		}
+	}
+
+	mapped_file(const mapped_file &) = delete;
+	auto operator=(const mapped_file &) -> mapped_file & = delete;
+
+	~mapped_file()
+	{
+		if (not bytes_.empty()) {
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+			::munmap(const_cast<char8_t *>(bytes_.data()), bytes_.size());
+		}
+	}
+
+	[[nodiscard]] auto bytes() const -> std::span<const char8_t> { return bytes_; }
+};
+
+/// @brief Transcode a sequence in chunks, and write the code units to an output if any
+///
+/// @return The number of code units
+template <typename Char>
+auto transcode(std::span<const char8_t> bytes, std::ofstream *output) -> std::size_t
+{
+	static constexpr std::size_t chunk_size = 0x100000;
+
+	utf8::stream_decoder decoder{};
+	std::vector<Char> buffer(utf8::stream_decoder::max_length(chunk_size));
+	std::size_t length{};
+
+	const auto write = [&](std::size_t size) {
+		length += size;
+		if (output != nullptr) {
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			output->write(reinterpret_cast<const char *>(buffer.data()),
+				      static_cast<std::streamsize>(size * sizeof(Char)));
+		}
+	};
+
+	for (std::size_t offset = 0; offset < bytes.size(); offset += chunk_size) {
+		const auto chunk = bytes.subspan(offset, std::min(chunk_size, bytes.size() - offset));
+		write(decoder.decode(chunk, buffer).produced);
+	}
+	if (const auto code = decoder.finish()) {
+		buffer[0] = static_cast<Char>(*code);
+		write(1);
+	}
+
+	return length;
+}
+
+enum class command { validate, count, utf16, utf32 };
+
+auto parse_command(std::string_view name) -> std::optional<command>
+{
+	if (name == "validate") {
+		return command::validate;
+	}
+	if (name == "count") {
+		return command::count;
+	}
+	if (name == "utf16") {
+		return command::utf16;
+	}
+	if (name == "utf32") {
+		return command::utf32;
+	}
+	return std::nullopt;
+}
+
+/// @brief Run a command on a file, and print its result and throughput
+///
+/// @return False if the file is not valid UTF-8 and the command is validation, true otherwise
+auto run(command cmd, const std::string &path, std::ofstream *output) -> bool
+{
+	const mapped_file file{path};
+	const auto bytes = file.bytes();
+	auto valid = true;
+	std::string result;
+
+	const auto start = std::chrono::steady_clock::now();
+	switch (cmd) {
+	case command::validate: {
+		const auto error = utf8::find_first_error(bytes);
+		valid = error == bytes.size();
+		result = valid ? "valid" : "first error at byte " + std::to_string(error);
+		break;
+	}
+	case command::count:
+		result = std::to_string(utf8::count_code_points(bytes)) + " code points";
+		break;
+	case command::utf16:
+		result = std::to_string(transcode<char16_t>(bytes, output)) + " UTF-16 code units";
+		break;
+	case command::utf32:
+		result = std::to_string(transcode<char32_t>(bytes, output)) + " code points";
+		break;
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	static constexpr auto giga = 1e9;
+	std::cout << path << ": " << result << ", " << bytes.size() << " bytes in " << std::fixed
+		  << std::setprecision(3) << elapsed.count() << " s";
+	if (elapsed.count() > 0) {
+		std::cout << " (" << std::setprecision(2) << static_cast<double>(bytes.size()) / elapsed.count() / giga
+			  << " GB/s)";
+	}
+	std::cout << '\n';
+
+	return valid;
+}
+
+} // namespace
+
+auto main(int argc, char *argv[]) -> int
+{
+	const std::vector<std::string> args(argv + 1, argv + argc);
+	const auto cmd = args.empty() ? std::nullopt : parse_command(args.front());
+	auto files = args.empty() ? args.end() : args.begin() + 1;
+
+	std::ofstream output;
+	if (cmd.has_value() and (*cmd == command::utf16 or *cmd == command::utf32) and files != args.end() and
+	    *files == "-o" and files + 1 != args.end()) {
+		output.open(*(files + 1), std::ios::binary);
+		if (not output) {
+			std::cerr << *(files + 1) << ": cannot open for writing\n";
+			return 2;
+		}
+		files += 2;
+	}
+
+	if (not cmd.has_value() or files == args.end()) {
+		std::cerr << "Usage: utf-8_tool validate|count|utf16|utf32 [-o OUTPUT] FILE...\n";
+		return 2;
+	}
+
+	auto status = 0;
+	for (; files != args.end(); ++files) {
+		try {
+			if (not run(*cmd, *files, output.is_open() ? &output : nullptr)) {
+				status = status == 0 ? 1 : status;
+			}
+		} catch (const std::system_error &error) {
+			std::cerr << error.what() << '\n';
+			status = 2;
+		}
+	}
+
+	if (output.is_open() and not output.flush()) {
+		std::cerr << "Cannot write the output\n";
+		status = 2;
+	}
+
+	return status;
+}